@@ -0,0 +1,126 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "libeconf.h"
+
+/* Benchmark:
+   Freeze files of 1000, 10000 and 100000 keys in 100 groups and look up
+   every key of them in random order, before and after econf_freeze(), and
+   the same number of missing keys.
+*/
+
+#define GROUPS 100
+#define LOOKUPS 10000000
+
+static double
+now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+report (const char *name, size_t keys, double start, long calls)
+{
+  double elapsed = now () - start;
+
+  printf ("%-24s %6zu keys %8.3f s %8.2f ns/call\n", name, keys, elapsed,
+	  elapsed * 1e9 / calls);
+}
+
+struct name
+{
+  char group[16];
+  char key[24];
+};
+
+static econf_err
+lookups (econf_file *key_file, const struct name *names, size_t keys,
+	 const char *name, econf_err expected)
+{
+  econf_err error = ECONF_SUCCESS;
+  const char *value;
+  double start = now ();
+
+  for (long n = 0; n < LOOKUPS; n++)
+    {
+      const struct name *nm = &names[n % keys];
+      if (econf_getStringValueRef(key_file, nm->group, nm->key, &value) != expected)
+	error = ECONF_ERROR;
+    }
+  report (name, keys, start, LOOKUPS);
+  return error;
+}
+
+static int
+run (size_t keys)
+{
+  econf_file *key_file = NULL;
+  struct name *names = calloc(keys, sizeof(struct name));
+  struct name *missing = calloc(keys, sizeof(struct name));
+  econf_err error;
+
+  if (names == NULL || missing == NULL ||
+      (error = econf_newKeyFile(&key_file, '=', '#')))
+    {
+      fprintf (stderr, "ERROR: couldn't create new file\n");
+      free (names);
+      free (missing);
+      return 1;
+    }
+
+  for (size_t i = 0; i < keys; i++)
+    {
+      snprintf (names[i].group, sizeof(names[i].group), "Group%zu", i % GROUPS);
+      snprintf (names[i].key, sizeof(names[i].key), "Key%zu", i);
+      snprintf (missing[i].group, sizeof(missing[i].group), "Group%zu", i % GROUPS);
+      snprintf (missing[i].key, sizeof(missing[i].key), "Missing%zu", i);
+      error |= econf_setStringValue(key_file, names[i].group, names[i].key, "value");
+    }
+
+  /* Random order, so the lookups do not walk the entries sequentially */
+  srand (1);
+  for (size_t i = keys - 1; i > 0; i--)
+    {
+      size_t j = (size_t) rand () % (i + 1);
+      struct name tmp = names[i];
+      names[i] = names[j];
+      names[j] = tmp;
+    }
+
+  error |= lookups (key_file, names, keys, "lookup (hit)", ECONF_SUCCESS);
+  error |= lookups (key_file, missing, keys, "lookup (miss)", ECONF_NOKEY);
+
+  double start = now ();
+  error |= econf_freeze(key_file);
+  report ("econf_freeze", keys, start, keys);
+
+  error |= lookups (key_file, names, keys, "frozen lookup (hit)", ECONF_SUCCESS);
+  error |= lookups (key_file, missing, keys, "frozen lookup (miss)", ECONF_NOKEY);
+
+  econf_free (key_file);
+  free (names);
+  free (missing);
+  if (error)
+    {
+      fprintf (stderr, "ERROR: lookups with %zu keys failed\n", keys);
+      return 1;
+    }
+  return 0;
+}
+
+int
+main(void)
+{
+  if (run (1000) || run (10000) || run (100000))
+    return 1;
+  return 0;
+}
@@ -0,0 +1,136 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "libeconf.h"
+
+/* Benchmark:
+   Read the same bool and int key 10 million times, through the normal
+   getters, with a precomputed key hash and through a resolved key handle.
+*/
+
+#define ITERATIONS 10000000
+
+static double
+now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+report (const char *name, double start)
+{
+  double elapsed = now () - start;
+
+  printf ("%-28s %8.3f s %8.2f ns/call\n", name, elapsed,
+	  elapsed * 1e9 / ITERATIONS);
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_keyhandle h_bool, h_int;
+  econf_err error = ECONF_SUCCESS;
+  volatile bool bval;
+  volatile int32_t ival;
+  bool b;
+  int32_t i;
+  double start;
+
+  if ((error = econf_newKeyFile(&key_file, '=', '#')))
+    {
+      fprintf (stderr, "ERROR: couldn't create new file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  /* Some surrounding keys, so the lookup is not trivial */
+  for (int n = 0; n < 100; n++)
+    {
+      char key[32];
+
+      snprintf (key, sizeof(key), "Key%d", n);
+      econf_setIntValue(key_file, "Limits", key, n);
+    }
+  econf_setBoolValue(key_file, "Features", "Enabled", "Yes");
+  econf_setIntValue(key_file, "Limits", "MaxConn", 1024);
+
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    {
+      error |= econf_getBoolValue(key_file, "Features", "Enabled", &b);
+      bval = b;
+    }
+  report ("econf_getBoolValue", start);
+
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    {
+      error |= econf_getIntValue(key_file, "Limits", "MaxConn", &i);
+      ival = i;
+    }
+  report ("econf_getIntValue", start);
+
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    {
+      error |= econf_getIntValueK(key_file, ECONF_KEY("Limits", "MaxConn"), &i);
+      ival = i;
+    }
+  report ("econf_getIntValueK", start);
+
+  error |= econf_resolveKey(key_file, "Features", "Enabled", &h_bool);
+  error |= econf_resolveKey(key_file, "Limits", "MaxConn", &h_int);
+
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    {
+      error |= econf_getBoolValueH(key_file, h_bool, &b);
+      bval = b;
+    }
+  report ("econf_getBoolValueH", start);
+
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    {
+      error |= econf_getIntValueH(key_file, h_int, &i);
+      ival = i;
+    }
+  report ("econf_getIntValueH", start);
+
+  /* Options which are not set in the file, answered by the defaults.
+     Counting the lookups costs an atomic add, it is only enabled here. */
+  econf_lookup_stats stats;
+  error |= econf_countLookups(key_file, true);
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    {
+      econf_getIntValueDef(key_file, "Limits", "MaxIdle", &i, 60);
+      ival = i;
+    }
+  report ("econf_getIntValueDef (miss)", start);
+  error |= econf_getLookupStats(key_file, &stats);
+  printf ("lookups: %llu hits, %llu filtered, %llu misses\n",
+	  (unsigned long long) stats.hits,
+	  (unsigned long long) stats.filtered,
+	  (unsigned long long) stats.misses);
+
+  (void) bval;
+  (void) ival;
+  econf_free (key_file);
+
+  if (error)
+    {
+      fprintf (stderr, "ERROR: reading values failed\n");
+      return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,286 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "libeconf.h"
+
+/* Benchmark:
+   Read a main file of 1000 keys in 100 groups and 500 drop-ins, each
+   overriding five keys, adding two keys to existing groups and one new
+   group, with econf_readDirs(). For comparison the same files are read
+   one by one and merged pairwise with econf_mergeFiles(), which is what
+   econf_readDirs() did before, and folded into the first file with
+   econf_mergeFilesInto(), which moves the strings instead of copying
+   them. After that one drop-in is changed and econf_refresh() brings the
+   result of econf_readDirsWithFlags() with ECONF_REFRESHABLE up to date.
+   malloc, calloc and realloc are interposed to count allocations.
+   Then merge two files of 1000 to 100000 keys each with econf_mergeFiles(),
+   the second one overriding half of the keys of the first one and adding
+   as many new ones, to show that the time grows linearly.
+*/
+
+#define DROPINS 500
+#define GROUPS 100
+#define KEYS 10
+#define ROUNDS 5
+
+static char dir[] = "/tmp/bench-merge-XXXXXX";
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static size_t allocations = 0;
+
+void *
+malloc(size_t size)
+{
+  allocations++;
+  return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+  allocations++;
+  return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+  allocations++;
+  return __libc_realloc(ptr, size);
+}
+
+enum merge_mode { MERGE_NONE, MERGE_COPY, MERGE_INTO };
+
+static double
+now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+report (const char *name, double start, size_t allocated)
+{
+  double elapsed = now () - start;
+
+  printf ("%-38s %8.3f s %8.2f ms/round %8zu allocs/round\n", name, elapsed,
+	  elapsed * 1e3 / ROUNDS, (allocations - allocated) / ROUNDS);
+}
+
+static int
+write_files (void)
+{
+  char path[256];
+  FILE *fp;
+
+  snprintf (path, sizeof(path), "%s/bench.conf.d", dir);
+  if (mkdir (path, 0755))
+    return 1;
+
+  snprintf (path, sizeof(path), "%s/bench.conf", dir);
+  if ((fp = fopen (path, "w")) == NULL)
+    return 1;
+  for (int g = 0; g < GROUPS; g++)
+    {
+      fprintf (fp, "[Group%d]\n", g);
+      for (int k = 0; k < KEYS; k++)
+	fprintf (fp, "Key%d=%d\n", k, k);
+    }
+  fclose (fp);
+
+  for (int d = 0; d < DROPINS; d++)
+    {
+      snprintf (path, sizeof(path), "%s/bench.conf.d/%03d.conf", dir, d);
+      if ((fp = fopen (path, "w")) == NULL)
+	return 1;
+      for (int i = 0; i < 5; i++)
+	fprintf (fp, "[Group%d]\nKey%d=dropin%d\n", (d * 7 + i) % GROUPS,
+		 (d + i) % KEYS, d);
+      fprintf (fp, "[Group%d]\nNew%d=1\nNew%d=2\n", d % GROUPS, d, d + DROPINS);
+      fprintf (fp, "[Dropin%d]\nA=1\nB=2\n", d);
+      fclose (fp);
+    }
+  return 0;
+}
+
+static void
+remove_files (void)
+{
+  char path[256];
+
+  for (int d = 0; d < DROPINS; d++)
+    {
+      snprintf (path, sizeof(path), "%s/bench.conf.d/%03d.conf", dir, d);
+      unlink (path);
+    }
+  snprintf (path, sizeof(path), "%s/bench.conf.d", dir);
+  rmdir (path);
+  snprintf (path, sizeof(path), "%s/bench.conf", dir);
+  unlink (path);
+  rmdir (dir);
+}
+
+/* Read all files, merging them pairwise as given by mode */
+static econf_err
+read_pairwise (enum merge_mode mode)
+{
+  econf_file *merged = NULL, *key_file, *tmp;
+  char path[256];
+  econf_err error;
+
+  snprintf (path, sizeof(path), "%s/bench.conf", dir);
+  if ((error = econf_readFile(&merged, path, "=", "#")))
+    return error;
+  for (int d = 0; d < DROPINS; d++)
+    {
+      snprintf (path, sizeof(path), "%s/bench.conf.d/%03d.conf", dir, d);
+      if ((error = econf_readFile(&key_file, path, "=", "#")))
+	break;
+      if (mode == MERGE_INTO)
+	{
+	  error = econf_mergeFilesInto(merged, key_file);
+	  key_file = NULL;
+	}
+      else if (mode == MERGE_COPY)
+	{
+	  tmp = merged;
+	  error = econf_mergeFiles(&merged, tmp, key_file);
+	  econf_free (tmp);
+	}
+      econf_free (key_file);
+      if (error)
+	return error;
+    }
+  econf_free (merged);
+  return error;
+}
+
+static econf_err
+merge_scaling (int keys)
+{
+  econf_file *usr_file = NULL, *etc_file = NULL, *merged;
+  econf_err error = ECONF_SUCCESS;
+  char group[32], key[32];
+
+  error |= econf_newKeyFile(&usr_file, '=', '#');
+  error |= econf_newKeyFile(&etc_file, '=', '#');
+  if (error)
+    return error;
+  for (int i = 0; i < keys; i++)
+    {
+      snprintf (group, sizeof(group), "Group%d", i / KEYS);
+      snprintf (key, sizeof(key), "Key%d", i);
+      error |= econf_setIntValue(usr_file, group, key, i);
+      snprintf (group, sizeof(group), "Group%d", (i + keys / 2) / KEYS);
+      snprintf (key, sizeof(key), "Key%d", i + keys / 2);
+      error |= econf_setIntValue(etc_file, group, key, -i);
+    }
+
+  double start = now ();
+  for (int r = 0; r < ROUNDS && !error; r++)
+    {
+      error |= econf_mergeFiles(&merged, usr_file, etc_file);
+      if (!error)
+	econf_free (merged);
+    }
+  double elapsed = now () - start;
+  printf ("econf_mergeFiles %6d + %6d keys %8.3f ms %8.2f ns/key\n",
+	  keys, keys, elapsed * 1e3 / ROUNDS, elapsed * 1e9 / ROUNDS / (2 * keys));
+
+  econf_free (usr_file);
+  econf_free (etc_file);
+  return error;
+}
+
+int
+main(void)
+{
+  econf_file *key_file;
+  econf_err error = ECONF_SUCCESS;
+  size_t allocated;
+  double start;
+
+  if (mkdtemp (dir) == NULL || write_files ())
+    {
+      fprintf (stderr, "ERROR: couldn't create the files in %s\n", dir);
+      remove_files ();
+      return 1;
+    }
+
+  allocated = allocations;
+  start = now ();
+  for (int r = 0; r < ROUNDS; r++)
+    error |= read_pairwise (MERGE_NONE);
+  report ("econf_readFile (no merge)", start, allocated);
+
+  allocated = allocations;
+  start = now ();
+  for (int r = 0; r < ROUNDS; r++)
+    error |= read_pairwise (MERGE_COPY);
+  report ("econf_readFile + econf_mergeFiles", start, allocated);
+
+  allocated = allocations;
+  start = now ();
+  for (int r = 0; r < ROUNDS; r++)
+    error |= read_pairwise (MERGE_INTO);
+  report ("econf_readFile + econf_mergeFilesInto", start, allocated);
+
+  allocated = allocations;
+  start = now ();
+  for (int r = 0; r < ROUNDS; r++)
+    {
+      error |= econf_readDirs(&key_file, NULL, dir, "bench", "conf", "=", "#");
+      if (!error)
+	econf_free (key_file);
+    }
+  report ("econf_readDirs", start, allocated);
+
+  /* Change one drop-in per round and refresh */
+  key_file = NULL;
+  error |= econf_readDirsWithFlags(&key_file, NULL, dir, "bench", "conf", "=",
+				   "#", ECONF_REFRESHABLE);
+  allocated = allocations;
+  start = now ();
+  for (int r = 0; r < ROUNDS && !error; r++)
+    {
+      char path[256];
+      FILE *fp;
+
+      snprintf (path, sizeof(path), "%s/bench.conf.d/%03d.conf", dir, r);
+      if ((fp = fopen (path, "a")) == NULL)
+	{
+	  error |= ECONF_NOFILE;
+	  break;
+	}
+      fprintf (fp, "[Group%d]\nKey0=refresh%d\n", r, r);
+      fclose (fp);
+      error |= econf_refresh(key_file);
+    }
+  report ("econf_refresh (one drop-in changed)", start, allocated);
+  econf_free (key_file);
+
+  remove_files ();
+
+  for (int keys = 1000; keys <= 100000; keys *= 10)
+    error |= merge_scaling (keys);
+
+  if (error)
+    {
+      fprintf (stderr, "ERROR: reading the files failed\n");
+      return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,95 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "parsenum.h"
+
+/* Benchmark:
+   Convert typical configuration values with the parsers of the library
+   and with the C library functions.
+*/
+
+#define ITERATIONS 1000000
+
+static const char *integers[] = {
+  "0", "1", "42", "-17", "1024", "65535", "4294967295", "-2147483648",
+  "9223372036854775807", "300"
+};
+static const char *reals[] = {
+  "0.5", "1.5", "3.14159", "-2.75", "100", "1e-3", "0.000001",
+  "2.718281828459045", "1.7976931348623157e+308", "12345.6789"
+};
+#define NUM (sizeof(integers) / sizeof(integers[0]))
+
+static double
+now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+report (const char *name, double start)
+{
+  double elapsed = now () - start;
+
+  printf ("%-28s %8.3f s %8.2f ns/call\n", name, elapsed,
+	  elapsed * 1e9 / (ITERATIONS * NUM));
+}
+
+int
+main(void)
+{
+  volatile int64_t ival;
+  volatile double dval;
+  int64_t i;
+  double d;
+  econf_err error = ECONF_SUCCESS;
+  double start;
+
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    for (size_t k = 0; k < NUM; k++)
+      {
+	error |= parse_signed (integers[k], INT64_MIN, INT64_MAX, &i);
+	ival = i;
+      }
+  report ("parse_signed", start);
+
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    for (size_t k = 0; k < NUM; k++)
+      ival = strtoll (integers[k], NULL, 10);
+  report ("strtoll", start);
+
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    for (size_t k = 0; k < NUM; k++)
+      {
+	error |= parse_double (reals[k], &d);
+	dval = d;
+      }
+  report ("parse_double", start);
+
+  start = now ();
+  for (long n = 0; n < ITERATIONS; n++)
+    for (size_t k = 0; k < NUM; k++)
+      dval = strtod (reals[k], NULL);
+  report ("strtod", start);
+
+  (void) ival;
+  (void) dval;
+  if (error)
+    {
+      fprintf (stderr, "ERROR: parsing failed\n");
+      return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,171 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "libeconf.h"
+
+/* Benchmark:
+   Read 40 projects, each with a vendor file of 50 keys and three
+   drop-ins in /etc, from directories which also hold 400 unrelated
+   files, like /usr/etc and /etc do. The projects are read one by one
+   with econf_readDirs() and all at once with econf_readDirsMulti(),
+   with one and with four threads.
+*/
+
+#define PROJECTS 40
+#define OTHERS 400
+#define KEYS 50
+#define DROPINS 3
+#define ROUNDS 50
+
+static char dir[] = "/tmp/bench-readmulti-XXXXXX";
+static char usr_dir[64], etc_dir[64];
+
+static double
+now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+report (const char *name, double start)
+{
+  double elapsed = now () - start;
+
+  printf ("%-34s %8.3f s %8.2f ms/round\n", name, elapsed,
+	  elapsed * 1e3 / ROUNDS);
+}
+
+static int
+write_file (const char *path, int keys, int value)
+{
+  FILE *fp;
+
+  if ((fp = fopen (path, "w")) == NULL)
+    return 1;
+  fprintf (fp, "[Main]\n");
+  for (int k = 0; k < keys; k++)
+    fprintf (fp, "Key%d=%d\n", k, value);
+  fclose (fp);
+  return 0;
+}
+
+/* With remove set, the files are removed instead */
+static int
+walk_files (bool remove)
+{
+  char path[256];
+  int error = 0;
+
+  for (int p = 0; p < PROJECTS; p++)
+    {
+      snprintf (path, sizeof(path), "%s/project%02d.conf", usr_dir, p);
+      error |= remove ? unlink (path) : write_file (path, KEYS, 0);
+      for (int d = 0; d < DROPINS; d++)
+	{
+	  snprintf (path, sizeof(path), "%s/project%02d.conf.d", etc_dir, p);
+	  if (!remove && d == 0)
+	    error |= mkdir (path, 0755);
+	  snprintf (path, sizeof(path), "%s/project%02d.conf.d/%d.conf",
+		    etc_dir, p, d);
+	  error |= remove ? unlink (path) : write_file (path, 5, d + 1);
+	}
+      snprintf (path, sizeof(path), "%s/project%02d.conf.d", etc_dir, p);
+      if (remove)
+	rmdir (path);
+    }
+  for (int o = 0; o < OTHERS; o++)
+    {
+      snprintf (path, sizeof(path), "%s/other%03d", usr_dir, o);
+      error |= remove ? unlink (path) : write_file (path, 1, 0);
+      snprintf (path, sizeof(path), "%s/other%03d", etc_dir, o);
+      error |= remove ? unlink (path) : write_file (path, 1, 0);
+    }
+  if (remove)
+    {
+      rmdir (usr_dir);
+      rmdir (etc_dir);
+      rmdir (dir);
+    }
+  return error;
+}
+
+int
+main(void)
+{
+  econf_project projects[PROJECTS];
+  econf_file *results[PROJECTS];
+  char names[PROJECTS][16];
+  econf_err error = ECONF_SUCCESS;
+  double start;
+
+  if (mkdtemp (dir) == NULL)
+    {
+      fprintf (stderr, "ERROR: couldn't create %s\n", dir);
+      return 1;
+    }
+  snprintf (usr_dir, sizeof(usr_dir), "%s/usr", dir);
+  snprintf (etc_dir, sizeof(etc_dir), "%s/etc", dir);
+  if (mkdir (usr_dir, 0755) || mkdir (etc_dir, 0755) || walk_files (false))
+    {
+      fprintf (stderr, "ERROR: couldn't create the files in %s\n", dir);
+      walk_files (true);
+      return 1;
+    }
+  for (int p = 0; p < PROJECTS; p++)
+    {
+      snprintf (names[p], sizeof(names[p]), "project%02d", p);
+      projects[p] = (econf_project) {names[p], "conf"};
+    }
+
+  /* Like an agent all projects are kept until the round is done */
+  start = now ();
+  for (int r = 0; r < ROUNDS; r++)
+    {
+      for (int p = 0; p < PROJECTS; p++)
+	{
+	  results[p] = NULL;
+	  error |= econf_readDirs(&results[p], usr_dir, etc_dir, names[p],
+				  "conf", "=", "#");
+	}
+      for (int p = 0; p < PROJECTS; p++)
+	econf_free (results[p]);
+    }
+  report ("econf_readDirs per project", start);
+
+  for (unsigned int threads = 1; threads <= 4; threads *= 4)
+    {
+      char name[64];
+
+      start = now ();
+      for (int r = 0; r < ROUNDS && !error; r++)
+	{
+	  error |= econf_readDirsMulti(results, NULL, projects, PROJECTS,
+				       usr_dir, etc_dir, "=", "#", threads, 0);
+	  for (int p = 0; p < PROJECTS; p++)
+	    econf_free (results[p]);
+	}
+      snprintf (name, sizeof(name), "econf_readDirsMulti, %u thread%s",
+		threads, threads > 1 ? "s" : "");
+      report (name, start);
+    }
+
+  walk_files (true);
+
+  if (error)
+    {
+      fprintf (stderr, "ERROR: reading the files failed\n");
+      return 1;
+    }
+  return 0;
+}
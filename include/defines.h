@@ -34,10 +34,6 @@
 
 /* NULL value */
 #define KEY_FILE_NULL_VALUE "_none_"
-#define KEY_FILE_NULL_VALUE_HASH hashstring(KEY_FILE_NULL_VALUE)
 
-/* Bool values */
-#define YES hashstring("yes")
-#define NO hashstring("no")
-#define TRUE hashstring("true")
-#define FALSE hashstring("false")
+/* file_entry.source of values which were not read from a file */
+#define KEY_FILE_NO_SOURCE UINT32_MAX
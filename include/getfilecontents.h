@@ -26,6 +26,18 @@
 #include "libeconf.h"
 #include "keyfile.h"
 
+/* Called by parse_file() for every entry found. group is NULL for entries
+   without group, value is NULL if the line has no delimiter.  */
+typedef econf_err (*store_fct)(void *arg, const char *group, const char *key,
+			       const char *value, uint64_t line_number);
+
+/* Parse the given file and pass every entry to store_entry. Returns
+   ECONF_NOFILE if the file cannot be opened and the first error returned
+   by store_entry.  */
+extern econf_err parse_file(const char *file, const char *delim,
+			    const char *comment, store_fct store_entry,
+			    void *arg);
+
 /* Fill the econf_file struct with values from the given file */
 extern econf_err read_file(econf_file *read_file, const char *file,
 			   const char *delim, const char *comment);
@@ -47,28 +47,48 @@ char *get_absolute_path(const char *path, econf_err *error);
          the brackets from group elements before returning them to the user  */
 char *stripbrackets(char *string);
 
-/* Add '[' and ']' to the given string */
+/* Add '[' and ']' to the given string, returns a refstr */
 char *addbrackets(const char *string);
 
+/* Group, key and value of the entries are immutable reference counted
+   strings (refstr). The count is stored in front of the characters, so
+   they are read like ordinary strings, but they must not be modified and
+   have to be released with refstr_unref() instead of free(). The count is
+   changed atomically, files sharing strings may be used and freed by
+   different threads.  */
+
+/* Returns a new refstr with a copy of string, NULL for NULL */
+char *refstr_new(const char *string);
+
+/* Takes another reference to a refstr and returns it */
+char *refstr_ref(char *string);
+
+/* Drops a reference, the string is freed with the last one. NULL is
+   ignored.  */
+void refstr_unref(char *string);
+
+/* Replace the entries and the index of dst by those of src and free src.
+   dst keeps its address, path, sources and lookup counters. src must be
+   indexed with the fold_case of dst.  */
+void move_file_contents(econf_file *dst, econf_file *src);
+
 /* Set default value defined in include/defines.h */
 void initialize(econf_file *key_file, size_t num);
 
-/* Return the lower case version of a string */
-char *toLowerCase(char *str);
+/* Compare two names, ignoring ASCII case if fold_case is set */
+bool names_equal(const char *a, const char *b, bool fold_case);
 
-/* Turn given string into a hash value */
-size_t hashstring(const char *str);
+/* Check whether the stored group name of an entry matches the given group.
+   Accepts the group with or without brackets and NULL/"" for no group.  */
+bool group_matches(const char *stored, const char *group, bool fold_case);
 
 /* Look for a matching key in the given econf_file.
    If the key is found num will point to the number of the array which contains
    the key, if not it will point to -1.  */
-econf_err find_key(econf_file key_file, const char *group, const char *key, size_t *num);
+econf_err find_key(econf_file *key_file, const char *group, const char *key, size_t *num);
 
 /* Set value for the given group, key combination. If the combination
    does not exist it is created.  */
 econf_err setKeyValue(econf_err (*function) (econf_file*, size_t, const void*),
                  econf_file *kf, const char *group, const char *key,
                  const void *value);
-
-/* Copy the contents of a file_entry struct */
-struct file_entry cpy_file_entry(struct file_entry fe);
@@ -39,10 +39,40 @@
 typedef struct econf_file {
   /* The file_entry struct contains the group, key and value of every
      key/value entry found in a config file or set via the set functions. If no
-     group is found or provided the group is set to KEY_FILE_NULL_VALUE.  */
+     group is found or provided the group is set to KEY_FILE_NULL_VALUE.
+     group, key and value are refstrs (see helpers.h) which may be shared
+     between entries and files, except in a frozen file.  */
   struct file_entry {
     char *group, *key, *value;
     uint64_t line_number;
+    /* Hash of group and key, see key_hash() in keyindex.h */
+    uint64_t hash;
+    /* The file the value was read from, line_number is its line there.
+       Index into paths of the econf_file, KEY_FILE_NO_SOURCE if the value
+       was set by the program.  */
+    uint32_t source;
+    /* Set by index_add() if this is the first entry of its group/key
+       combination, the one returned by the getters. last is the number
+       of the last entry of the combination then.  */
+    bool indexed;
+    size_t last;
+    /* Result of the first typed getter call for this entry, so that the
+       value is parsed only once. Reset to CACHE_NONE whenever the value
+       changes. CACHE_BUSY while a getter fills it.  */
+    enum cache_type {
+      CACHE_NONE = 0, CACHE_INT, CACHE_INT64, CACHE_UINT, CACHE_UINT64,
+      CACHE_FLOAT, CACHE_DOUBLE, CACHE_BOOL, CACHE_BUSY
+    } cache_type;
+    econf_err cache_error;
+    union {
+      int32_t i32;
+      int64_t i64;
+      uint32_t u32;
+      uint64_t u64;
+      float f;
+      double d;
+      bool b;
+    } cache;
   } * file_entry;
   /* length represents the current amount of key/value entries in econf_file and
      alloc_length the the amount of currently allocated file_entry elements
@@ -58,9 +88,76 @@ typedef struct econf_file {
   /* Binary variable to determine whether econf_file should be freed after
      being merged with another econf_file.  */
   bool on_merge_delete;
+  /* Group and key names are matched ignoring ASCII case, see
+     ECONF_CASE_INSENSITIVE. The index hashes the folded names.  */
+  bool fold_case;
+  /* The file this one was read from, a refstr */
   char *path;
+  /* Paths (refstrs) of all files the values come from, see
+     file_entry.source. A merged file has the paths of all its inputs.  */
+  char **paths;
+  size_t path_length;
+  /* Changes whenever the entries are modified. Values are taken from a
+     library wide counter, so no two econf_files share a generation. Used to
+     detect outdated econf_keyhandles.  */
+  uint64_t generation;
+  /* Index over the first length entries, maintained by keyindex.c.
+     groups holds every group in order of its first appearance together
+     with the entries defining its keys. key_table and group_table are
+     open addressing hash tables of size key_table_size/group_table_size
+     (a power of two) which contain entry number + 1 resp. group number + 1,
+     0 marks an empty slot.  */
+  struct econf_group {
+    /* Points to the group of the first entry of this group */
+    const char *name;
+    uint64_t hash;
+    /* Entry numbers of the first occurrence of every key in this group */
+    size_t *keys;
+    size_t key_length, key_alloc_length;
+    /* The same keys sorted by name, built on demand for prefix queries.
+       NULL if not built yet or outdated by a new key.  */
+    struct econf_sorted_key {
+      const char *key;
+      size_t num;
+    } *sorted;
+  } *groups;
+  size_t group_length, group_alloc_length;
+  size_t *key_table, key_table_size, key_table_used;
+  /* Bloom filter over the hashes in key_table with two bits per key in
+     one word, consulted before key_table. It has key_table_size / 8
+     words, so it uses 16 or more bits per key.  */
+  uint64_t *filter;
+  size_t filter_words;
+  /* Lookup counters, only updated if count_lookups is set, see
+     econf_countLookups() and econf_getLookupStats() */
+  bool count_lookups;
+  uint64_t lookup_hits, lookup_misses, lookup_filtered, lookup_perfect;
+  /* Set by econf_freeze(). The entries and all their strings are stored
+     in the single block file_entry, keys are found with the minimal
+     perfect hash mph and nothing but the lookup counters, if enabled,
+     is written by the getters any more.  */
+  bool frozen;
+  /* Minimal perfect hash over the indexed entries, used instead of
+     key_table if size is not 0. A key falls into one of buckets buckets,
+     the two displacements of the bucket (disp[2 * bucket] and
+     disp[2 * bucket + 1]) select its slot in slots, which holds the
+     entry number. reciprocal is 2^64 / size rounded up, for taking the
+     slot modulo size without a division.  */
+  struct econf_mph {
+    uint64_t seed, reciprocal;
+    size_t size, buckets;
+    uint32_t *disp;
+    size_t *slots;
+  } mph;
+  size_t *group_table, group_table_size;
+  /* The files econf_readDirs() merged into this one, kept for
+     econf_refresh(). NULL for all other files, see sources.h.  */
+  struct econf_sources *sources;
 } econf_file;
 
+/* Assign a new generation to key_file, invalidating all handles to it */
+void new_generation(econf_file *key_file);
+
 /* Increases both length and alloc_length of key_file by one and initializes
    new elements of struct file_entry.  */
 econf_err key_file_append(econf_file *key_file);
@@ -70,7 +167,10 @@ econf_err key_file_append(econf_file *key_file);
 /* Functions used to get a set value from key_file depending on num.
    Expects a pointer of fitting type and writes the result into the pointer.
    num corresponds to the respective instance of the file_entry array.
-   TODO: Error checking and defining return value on error needs to done.  */
+   The typed getters return ECONF_PARSE_ERROR if the value is not of the
+   type or out of its range, ECONF_EMPTYKEY if there is no value and
+   ECONF_NOMEM if out of memory; result is left alone then.
+   getStringValueNum() stores a copy of the value, NULL if there is none.  */
 econf_err getIntValueNum(econf_file key_file, size_t num, int32_t *result);
 econf_err getInt64ValueNum(econf_file key_file, size_t num, int64_t *result);
 econf_err getUIntValueNum(econf_file key_file, size_t num, uint32_t *result);
@@ -80,6 +180,10 @@ econf_err getDoubleValueNum(econf_file key_file, size_t num, double *result);
 econf_err getStringValueNum(econf_file key_file, size_t num, char **result);
 econf_err getBoolValueNum(econf_file key_file, size_t num, bool *result);
 
+/* Convert value into the given type without an econf_file. Strings are
+   duplicated.  */
+econf_err parseValue(econf_type type, const char *value, void *result);
+
 /* SETTERS */
 
 /* Set the group of the file_entry element number num */
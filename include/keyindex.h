@@ -0,0 +1,74 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+/* --- keyindex.h --- */
+
+#include "keyfile.h"
+
+/* This file contains the declaration of the functions maintaining the
+   group and key index of an econf_file. The index maps a group/key
+   combination to the first entry defining it and lists the groups and
+   their keys in order of their first appearance.  */
+
+
+/* Hash of a group/key combination: djb2 over the group name without
+   brackets (the empty string for no group), a '\0' separator and the key.
+   group is given as passed by the caller ("name", "[name]" or NULL).
+   With fold_case, group and key are hashed in lower case.  */
+uint64_t key_hash(const char *group, const char *key, bool fold_case);
+
+/* Add entry number num to the index. Must be called for every entry
+   appended to the econf_file.  */
+econf_err index_add(econf_file *key_file, size_t num);
+
+/* Drop the current index and index all entries of key_file again */
+econf_err index_build(econf_file *key_file);
+
+/* Free the memory used by the index */
+void index_free(econf_file *key_file);
+
+/* Look for the group matching the given group name ("name", "[name]" or
+   NULL/"" for no group). Returns NULL if the group does not exist.  */
+struct econf_group *index_find_group(econf_file *key_file, const char *group);
+
+/* Find the keys of grp starting with the first length characters of
+   prefix. They are returned as range [*first, *last) of grp->sorted,
+   which is built if needed.  */
+econf_err index_prefix_range(econf_file *key_file, struct econf_group *grp,
+                             const char *prefix, size_t length,
+                             size_t *first, size_t *last);
+
+/* Build the minimal perfect hash and the sorted key arrays of all groups,
+   so that lookups do not modify the index any more. If no perfect hash
+   can be found, key_table stays in use.  */
+econf_err index_freeze(econf_file *key_file);
+
+/* Look for the first entry matching group and key. Returns ECONF_NOKEY
+   if there is none.  */
+econf_err index_find_key(econf_file *key_file, const char *group,
+                         const char *key, size_t *num);
+
+/* Same as index_find_key() with hash already computed by key_hash() */
+econf_err index_find_hash(econf_file *key_file, uint64_t hash,
+                          const char *group, const char *key, size_t *num);
@@ -46,11 +46,20 @@ enum econf_err {
   ECONF_NOKEY = 5, /* Key not found */
   ECONF_EMPTYKEY = 6, /* Key has empty value */
   ECONF_WRITEERROR = 7, /* Error creating or writing to a file */
-  ECONF_PARSE_ERROR = 8 /* Syntax error in input file */
+  ECONF_PARSE_ERROR = 8, /* Syntax error in input file */
+  ECONF_INVALID_HANDLE = 9, /* Handle or iterator is stale or of another file */
+  ECONF_FROZEN = 10 /* File has been frozen and cannot be modified */
 };
 
 typedef enum econf_err econf_err;
 
+/* Flags for econf_readFileWithFlags() and econf_readDirsWithFlags(), can
+   be combined with | */
+enum econf_flags {
+  ECONF_CASE_INSENSITIVE = 1 << 0, /* Match group and key names ignoring ASCII case */
+  ECONF_REFRESHABLE = 1 << 1 /* Keep the parsed files for econf_refresh() */
+};
+
 /* Generic macro calls setter function depending on value type
    Use: econf_setValue(econf_file *key_file, char *group, char *key,
                        _generic_ value);
@@ -77,19 +86,154 @@ typedef enum econf_err econf_err;
 #define econf_free(value) (( \
   _Generic((value), \
     econf_file*: econf_freeFile , \
+    econf_overlay*: econf_freeOverlay , \
+    econf_handle*: econf_freeHandle , \
     char**: econf_freeArray)) \
 (value))
 
 typedef struct econf_file econf_file;
 
+/* Stack of config files answering lookups like the file merged from them
+   would, see econf_readDirsOverlay(). */
+typedef struct econf_overlay econf_overlay;
+
+/* Current configuration shared between threads, see econf_newHandle(). */
+typedef struct econf_handle econf_handle;
+
+/* Snapshot of an econf_handle pinned by econf_handleAcquire(). file can be
+   read with all getters until econf_handleRelease(); epoch is private. */
+typedef struct econf_snapshot {
+  econf_file *file;
+  uint64_t epoch;
+} econf_snapshot;
+
+/* Handle to a key resolved with econf_resolveKey(). The members are private
+   to the library. A handle stays valid until the econf_file it was resolved
+   in gets modified or freed.  */
+typedef struct econf_keyhandle {
+  size_t num;
+  uint64_t generation;
+} econf_keyhandle;
+
+/* Maximum length of the group and of the key name given to ECONF_KEY() */
+#define ECONF_KEY_MAX 64
+
+/* Hash of a group/key combination as used by the key index of an
+   econf_file: djb2 (hash = hash * 33 + c, starting with 5381, unsigned
+   64 bit arithmetic) over the bytes of the group name without brackets,
+   a '\0' byte and the bytes of the key name. Keys without group use the
+   empty group name "". Files read with ECONF_CASE_INSENSITIVE hash the
+   names in lower case instead.
+   ECONF_KEY_HASH() computes it at compile time for string literals of up
+   to ECONF_KEY_MAX characters; longer names do not compile.  */
+#define ECONF_HASH_STEP_(h, s, i) \
+  ((h) * ((i) < sizeof(s) - 1 ? 33U : 1U) + \
+   ((i) < sizeof(s) - 1 ? (unsigned char) (s)[(i) < sizeof(s) - 1 ? (i) : 0] : 0U))
+#define ECONF_HASH4_(h, s, i) \
+  ECONF_HASH_STEP_(ECONF_HASH_STEP_(ECONF_HASH_STEP_(ECONF_HASH_STEP_( \
+    h, s, i), s, (i) + 1), s, (i) + 2), s, (i) + 3)
+#define ECONF_HASH16_(h, s, i) \
+  ECONF_HASH4_(ECONF_HASH4_(ECONF_HASH4_(ECONF_HASH4_( \
+    h, s, i), s, (i) + 4), s, (i) + 8), s, (i) + 12)
+#define ECONF_HASH64_(h, s) \
+  (ECONF_HASH16_(ECONF_HASH16_(ECONF_HASH16_(ECONF_HASH16_( \
+    h, s, 0), s, 16), s, 32), s, 48) + \
+   0 * sizeof(char[sizeof(s) <= ECONF_KEY_MAX + 1 ? 1 : -1]))
+#define ECONF_KEY_HASH(group, key) \
+  ECONF_HASH64_(ECONF_HASH64_((uint64_t) 5381, group) * 33U, key)
+
+/* Group/key combination with its precomputed hash for the econf_get*ValueK()
+   getters. group is the group name without brackets or "" for no group,
+   both must be string literals.
+   Use: econf_getIntValueK(kf, ECONF_KEY("Limits", "MaxConn"), &max);  */
+typedef struct econf_key {
+  const char *group;
+  const char *key;
+  uint64_t hash;
+} econf_key;
+
+#define ECONF_KEY(group, key) \
+  ((econf_key) { (group), (key), ECONF_KEY_HASH(group, key) })
+
+/* Key lookups of an econf_file while counting was enabled, see
+   econf_countLookups() and econf_getLookupStats() */
+typedef struct econf_lookup_stats {
+  uint64_t hits; /* Keys found */
+  uint64_t filtered; /* Missing keys rejected by the membership filter */
+  uint64_t misses; /* Missing keys which had to be searched in the index */
+  uint64_t perfect; /* Hits and misses answered by the perfect hash of a
+		       frozen file, see econf_freeze() */
+} econf_lookup_stats;
+
+/* Value types which can be requested with econf_getBatch() */
+typedef enum econf_type {
+  ECONF_TYPE_INT, /* int32_t */
+  ECONF_TYPE_INT64, /* int64_t */
+  ECONF_TYPE_UINT, /* uint32_t */
+  ECONF_TYPE_UINT64, /* uint64_t */
+  ECONF_TYPE_FLOAT, /* float */
+  ECONF_TYPE_DOUBLE, /* double */
+  ECONF_TYPE_STRING, /* char *, newly allocated */
+  ECONF_TYPE_BOOL /* bool */
+} econf_type;
+
+/* One value requested with econf_getBatch().
+   result points to a variable of the given type. def points to the
+   default value of the same type, for ECONF_TYPE_STRING it is the default
+   string itself. If def is NULL, a missing key leaves result untouched.
+   If status is not NULL, it receives the result of this query.  */
+typedef struct econf_query {
+  const char *group;
+  const char *key;
+  econf_type type;
+  void *result;
+  const void *def;
+  econf_err *status;
+} econf_query;
+
+/* One member of a settings struct filled by econf_bind() or
+   econf_readDirsInto(). offset is offsetof(struct, member), def points
+   to the default value as in econf_query.  */
+typedef struct econf_field {
+  const char *group;
+  const char *key;
+  econf_type type;
+  size_t offset;
+  const void *def;
+} econf_field;
+
+/* A project read by econf_readDirsMulti() */
+typedef struct econf_project {
+  const char *project_name;
+  const char *config_suffix;
+} econf_project;
+
 // Process the file of the given file_name and save its contents into key_file
 extern econf_err econf_readFile(econf_file **result, const char *file_name,
 				    const char *delim, const char *comment);
 
+// Like econf_readFile, flags is a combination of enum econf_flags. The
+// flags apply to all lookups in the returned file, they are not passed
+// on by econf_mergeFiles.
+extern econf_err econf_readFileWithFlags(econf_file **result,
+					 const char *file_name,
+					 const char *delim,
+					 const char *comment,
+					 unsigned int flags);
+
 // Merge the contents of two key files
 extern econf_err econf_mergeFiles(econf_file **merged_file,
 				       econf_file *usr_file, econf_file *etc_file);
 
+// Merge src into dst like econf_mergeFiles(dst, src) would, but without
+// copying: the strings of both files are moved into the result, which
+// replaces the contents of dst. Both files must have been read with the
+// same ECONF_CASE_INSENSITIVE flag, which dst keeps. dst can't be
+// refreshed afterwards. src is freed, unless ECONF_ERROR or ECONF_FROZEN
+// is returned for invalid arguments or a frozen dst. If merging fails,
+// dst is left empty.
+extern econf_err econf_mergeFilesInto(econf_file *dst, econf_file *src);
+
 extern econf_err econf_readDirs(econf_file **key_file,
 					  const char *usr_conf_dir,
 					  const char *etc_conf_dir,
@@ -98,6 +242,130 @@ extern econf_err econf_readDirs(econf_file **key_file,
 					  const char *delim,
 					  const char *comment);
 
+/* Like econf_readDirs(), flags is a combination of enum econf_flags. Only
+   ECONF_REFRESHABLE is supported: the parsed files are kept with the
+   result, so that econf_refresh() can bring it up to date later. They
+   are dropped by econf_freeze().  */
+extern econf_err econf_readDirsWithFlags(econf_file **key_file,
+					 const char *usr_conf_dir,
+					 const char *etc_conf_dir,
+					 const char *project_name,
+					 const char *config_suffix,
+					 const char *delim,
+					 const char *comment,
+					 unsigned int flags);
+
+/* Bring a file returned by econf_readDirsWithFlags() with
+   ECONF_REFRESHABLE up to date with the configuration files. Only files
+   which are new or whose size, inode or times changed are parsed again,
+   files which are gone are dropped. If
+   any file changed, the contents are merged anew, dropping changes made
+   with the setters; otherwise key_file is left alone and its handles
+   stay valid. Returns ECONF_ERROR for files read without
+   ECONF_REFRESHABLE; on any other error key_file is unchanged.  */
+extern econf_err econf_refresh(econf_file *key_file);
+
+/* Read n projects like econf_readDirs() would, results[i] gets the merged
+   file of projects[i] and status[i] its result, NULL for failed projects.
+   With threads > 1 up to that many threads, including the calling one,
+   read the projects in parallel. flags is passed on to
+   econf_readDirsWithFlags(). Returns the first error of any project in
+   order of projects; status may be NULL.  */
+extern econf_err econf_readDirsMulti(econf_file **results, econf_err *status,
+				     const econf_project *projects, size_t n,
+				     const char *dist_conf_dir,
+				     const char *etc_conf_dir,
+				     const char *delim, const char *comment,
+				     unsigned int threads, unsigned int flags);
+
+/* Read the same files as econf_readDirs(), but store the values described
+   by the n fields of schema directly into dest without keeping the
+   parsed files in memory. Fields are first set to their default, string
+   fields without default to NULL. Later files override earlier ones.
+   status, if not NULL, receives the result of every field as with
+   econf_bind().  */
+extern econf_err econf_readDirsInto(const econf_field *schema, size_t n,
+				    void *dest, econf_err *status,
+				    const char *usr_conf_dir,
+				    const char *etc_conf_dir,
+				    const char *project_name,
+				    const char *config_suffix,
+				    const char *delim,
+				    const char *comment);
+
+/* Read the same files as econf_readDirs(), but keep them as separate
+   layers instead of merging them into a copy. The econf_overlayGet*Value()
+   functions return the value econf_readDirs() would have produced by
+   searching the layers from the last one read down to the first. */
+extern econf_err econf_readDirsOverlay(econf_overlay **result,
+				       const char *dist_conf_dir,
+				       const char *etc_conf_dir,
+				       const char *project_name,
+				       const char *config_suffix,
+				       const char *delim,
+				       const char *comment);
+
+/* Read the same files as econf_readDirs() into a frozen snapshot (see
+   econf_freeze()) and keep it in a handle, which any number of threads
+   can read while another one reloads it.
+   Use: econf_snapshot snap;
+        econf_handleAcquire(h, &snap);
+        econf_getIntValue(snap.file, ...); ...
+        econf_handleRelease(h, &snap);
+   Readers never block and never see a partially read configuration. */
+extern econf_err econf_newHandle(econf_handle **result,
+				 const char *dist_conf_dir,
+				 const char *etc_conf_dir,
+				 const char *project_name,
+				 const char *config_suffix,
+				 const char *delim,
+				 const char *comment);
+
+/* Read the files again and publish the result with econf_handlePublish().
+   If reading fails, the current snapshot stays in place. */
+extern econf_err econf_handleReload(econf_handle *h);
+
+/* Freeze key_file and make it the current snapshot of h, which takes
+   ownership of it. Returns after all readers which may still use the
+   previous snapshot have released it and the previous one is freed. */
+extern econf_err econf_handlePublish(econf_handle *h, econf_file *key_file);
+
+/* Pin the current snapshot of h. Snapshots are meant to be held briefly,
+   econf_handlePublish() waits for them. */
+extern econf_err econf_handleAcquire(econf_handle *h, econf_snapshot *snapshot);
+
+/* Release a snapshot pinned by econf_handleAcquire() */
+extern void econf_handleRelease(econf_handle *h, econf_snapshot *snapshot);
+
+/* Create an empty overlay. */
+extern econf_err econf_newOverlay(econf_overlay **result);
+
+/* Add layer on top of all layers of ov. ov takes ownership of layer and
+   frees it with econf_freeOverlay(). The layer must not be modified while
+   it is part of ov. */
+extern econf_err econf_overlayAddLayer(econf_overlay *ov, econf_file *layer);
+
+/* Replace layer number pos (0 is the lowest) by layer, freeing the old
+   one. Nothing else is rebuilt. */
+extern econf_err econf_overlaySetLayer(econf_overlay *ov, size_t pos, econf_file *layer);
+
+/* Return the number of layers of ov. */
+extern econf_err econf_overlayLength(econf_overlay *ov, size_t *length);
+
+/* Same as the econf_get*Value() functions for the merged layers of ov. */
+extern econf_err econf_overlayGetIntValue(econf_overlay *ov, const char *group, const char *key, int32_t *result);
+extern econf_err econf_overlayGetInt64Value(econf_overlay *ov, const char *group, const char *key, int64_t *result);
+extern econf_err econf_overlayGetUIntValue(econf_overlay *ov, const char *group, const char *key, uint32_t *result);
+extern econf_err econf_overlayGetUInt64Value(econf_overlay *ov, const char *group, const char *key, uint64_t *result);
+extern econf_err econf_overlayGetFloatValue(econf_overlay *ov, const char *group, const char *key, float *result);
+extern econf_err econf_overlayGetDoubleValue(econf_overlay *ov, const char *group, const char *key, double *result);
+/* Returns a newly allocated string or NULL in error case. */
+extern econf_err econf_overlayGetStringValue(econf_overlay *ov, const char *group, const char *key, char **result);
+extern econf_err econf_overlayGetBoolValue(econf_overlay *ov, const char *group, const char *key, bool *result);
+/* result points into the layer defining the value, see
+   econf_getStringValueRef(). */
+extern econf_err econf_overlayGetStringValueRef(econf_overlay *ov, const char *group, const char *key, const char **result);
+
 /* The API/ABI of the following three functions (econf_newKeyFile,
    econf_newIniFile and econf_writeFile) are not stable and will change */
 
@@ -111,8 +379,18 @@ extern econf_err econf_writeFile(econf_file *key_file, const char *save_to_dir,
 
 /* --- GETTERS --- */
 
+/* The numeric getters only accept decimal numbers, independent of the
+   locale. Values which are not a number or out of range for the
+   requested type result in ECONF_PARSE_ERROR, empty values in
+   ECONF_EMPTYKEY. */
+
 extern econf_err econf_getGroups(econf_file *kf, size_t *length, char ***groups);
 extern econf_err econf_getKeys(econf_file *kf, const char *group, size_t *length, char ***keys);
+/* Like econf_getKeys, but only the keys starting with prefix resp. matching
+   the shell wildcard pattern (see fnmatch(3)). Returns ECONF_NOKEY if no
+   key matches. */
+extern econf_err econf_getKeysPrefix(econf_file *kf, const char *group, const char *prefix, size_t *length, char ***keys);
+extern econf_err econf_getKeysGlob(econf_file *kf, const char *group, const char *pattern, size_t *length, char ***keys);
 extern econf_err econf_getIntValue(econf_file *kf, const char *group, const char *key, int32_t *result);
 extern econf_err econf_getInt64Value(econf_file *kf, const char *group, const char *key, int64_t *result);
 extern econf_err econf_getUIntValue(econf_file *kf, const char *group, const char *key, uint32_t *result);
@@ -123,6 +401,101 @@ extern econf_err econf_getDoubleValue(econf_file *kf, const char *group, const c
 extern econf_err econf_getStringValue(econf_file *kf, const char *group, const char *key, char **result);
 extern econf_err econf_getBoolValue(econf_file *kf, const char *group, const char *key, bool *result);
 
+/* Return the value stored in kf instead of a copy. The string must not be
+   freed and is only valid until kf is modified or freed. If the key has no
+   value, result is set to NULL. */
+extern econf_err econf_getStringValueRef(econf_file *kf, const char *group, const char *key, const char **result);
+/* Same as econf_getStringValueRef(), additionally returns the string length */
+extern econf_err econf_getStringValueRefLen(econf_file *kf, const char *group, const char *key, const char **result, size_t *length);
+
+/* Return the file and line the value of key was read from. For merged
+   files this is the file which provided the value. path points into kf
+   like the result of econf_getStringValueRef(); it is NULL and
+   line_number is 0 if the value was set by the program. line_number may
+   be NULL.  */
+extern econf_err econf_getValueSource(econf_file *kf, const char *group, const char *key, const char **path, uint64_t *line_number);
+
+/* Same as the econf_get*Value() functions, but the key is found with the
+   hash precomputed by ECONF_KEY(), so only one probe of the index and one
+   comparison of the names are needed. */
+extern econf_err econf_getIntValueK(econf_file *kf, econf_key key, int32_t *result);
+extern econf_err econf_getInt64ValueK(econf_file *kf, econf_key key, int64_t *result);
+extern econf_err econf_getUIntValueK(econf_file *kf, econf_key key, uint32_t *result);
+extern econf_err econf_getUInt64ValueK(econf_file *kf, econf_key key, uint64_t *result);
+extern econf_err econf_getFloatValueK(econf_file *kf, econf_key key, float *result);
+extern econf_err econf_getDoubleValueK(econf_file *kf, econf_key key, double *result);
+/* Returns a newly allocated string or NULL in error case. */
+extern econf_err econf_getStringValueK(econf_file *kf, econf_key key, char **result);
+extern econf_err econf_getBoolValueK(econf_file *kf, econf_key key, bool *result);
+
+/* Order in which econf_iterInit() walks the entries */
+enum econf_iter_order {
+  ECONF_ITER_FILE_ORDER, /* In the order they have been read or set */
+  ECONF_ITER_GROUPED /* Group by group, keys in order of first appearance */
+};
+
+/* Cursor over the entries of an econf_file, see econf_iterInit(). The
+   first members describe the current entry, the others are private. */
+typedef struct econf_iter {
+  const char *group; /* "[name]", NULL for keys without group */
+  const char *key;
+  const char *value;
+  uint64_t line_number; /* Line in the file it has been read from, 0 if set */
+  econf_file *kf;
+  uint64_t generation;
+  enum econf_iter_order order;
+  size_t group_pos, pos;
+} econf_iter;
+
+/* Prepare iter for walking over all keys of kf and their values, in file
+   order or grouped. Every key is returned once, with the value returned by
+   the getters. Nothing is allocated; group, key and value point into kf,
+   see econf_getStringValueRef().
+   Use: econf_iter iter;
+        econf_iterInit(kf, ECONF_ITER_GROUPED, &iter);
+        while (!econf_iterNext(&iter)) ... iter.group, iter.key ... */
+extern econf_err econf_iterInit(econf_file *kf, enum econf_iter_order order, econf_iter *iter);
+
+/* Advance iter to the next entry. Returns ECONF_NOKEY if there are no more
+   entries and ECONF_INVALID_HANDLE if kf has been modified since
+   econf_iterInit(). */
+extern econf_err econf_iterNext(econf_iter *iter);
+
+/* Start (enable true) or stop counting the lookups in kf. Counting is off
+   by default, so that readers sharing a file do not write to it. Returns
+   ECONF_FROZEN for a frozen file, enable counting before econf_freeze(). */
+extern econf_err econf_countLookups(econf_file *kf, bool enable);
+
+/* Return the lookup counters of kf. While counting is enabled, every
+   search for a key by group and key name is counted, also those done by
+   the setters. */
+extern econf_err econf_getLookupStats(econf_file *kf, econf_lookup_stats *stats);
+
+/* Make kf immutable. The entries and all their strings are compacted into
+   a single block and keys are looked up by a minimal perfect hash. From
+   now on the setters return ECONF_FROZEN and the getters do not modify kf
+   any more, so it can be read from any number of threads concurrently
+   without locking. Strings borrowed with econf_getStringValueRef() or
+   econf_iterNext() before are no longer valid; key handles stay valid.
+   Freezing a frozen file does nothing. */
+extern econf_err econf_freeze(econf_file *kf);
+
+/* Resolve group and key once, so that repeated reads through the returned
+   handle need no lookup at all. */
+extern econf_err econf_resolveKey(econf_file *kf, const char *group, const char *key, econf_keyhandle *handle);
+
+/* Return ECONF_INVALID_HANDLE if kf has been modified since the handle was
+   resolved. In this case call econf_resolveKey() again. */
+extern econf_err econf_getIntValueH(econf_file *kf, econf_keyhandle handle, int32_t *result);
+extern econf_err econf_getInt64ValueH(econf_file *kf, econf_keyhandle handle, int64_t *result);
+extern econf_err econf_getUIntValueH(econf_file *kf, econf_keyhandle handle, uint32_t *result);
+extern econf_err econf_getUInt64ValueH(econf_file *kf, econf_keyhandle handle, uint64_t *result);
+extern econf_err econf_getFloatValueH(econf_file *kf, econf_keyhandle handle, float *result);
+extern econf_err econf_getDoubleValueH(econf_file *kf, econf_keyhandle handle, double *result);
+/* Returns a newly allocated string or NULL in error case. */
+extern econf_err econf_getStringValueH(econf_file *kf, econf_keyhandle handle, char **result);
+extern econf_err econf_getBoolValueH(econf_file *kf, econf_keyhandle handle, bool *result);
+
 /* If key is not found, the default value is returned and error is ECONF_NOKEY */
 extern econf_err econf_getIntValueDef(econf_file *kf, const char *group, const char *key, int32_t *result, int32_t def);
 extern econf_err econf_getInt64ValueDef(econf_file *kf, const char *group, const char *key, int64_t *result, int64_t def);
@@ -134,6 +507,18 @@ extern econf_err econf_getDoubleValueDef(econf_file *kf, const char *group, cons
 extern econf_err econf_getStringValueDef(econf_file *kf, const char *group, const char *key, char **result, char *def);
 extern econf_err econf_getBoolValueDef(econf_file *kf, const char *group, const char *key, bool *result, bool def);
 
+/* Read the values of n queries at once. Every query behaves like the
+   matching econf_get*ValueDef() function, or econf_get*Value() if it has
+   no default. Returns ECONF_SUCCESS if every key was found or a default
+   was used, otherwise the error of the first failed query. */
+extern econf_err econf_getBatch(econf_file *kf, const econf_query *q, size_t n);
+
+/* Fill the members of the struct dest described by the n fields of
+   schema like econf_getBatch() does. status, if not NULL, is an array of
+   n elements receiving the result of every field. String members are
+   newly allocated.  */
+extern econf_err econf_bind(econf_file *kf, const econf_field *schema, size_t n, void *dest, econf_err *status);
+
 /* --- SETTERS --- */
 
 extern econf_err econf_setIntValue(econf_file *kf, const char *group, const char *key, int32_t value);
@@ -156,6 +541,12 @@ extern void econf_freeArray(char **array);
 // Free memory allocated by key_file
 extern void econf_freeFile(econf_file *key_file);
 
+// Free ov and all its layers
+extern void econf_freeOverlay(econf_overlay *ov);
+
+// Free h and its snapshot. No thread may use h any more.
+extern void econf_freeHandle(econf_handle *h);
+
 #ifdef __cplusplus
 }
 #endif
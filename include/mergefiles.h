@@ -27,30 +27,44 @@
 
 #include <stddef.h>
 
-/* This file contains the declaration of the functions used by econf_mergeFiles
-   to merge the contents of two econf_files.  */
+/* This file contains the declaration of the functions used by
+   econf_mergeFiles and econf_readDirs to find and merge econf_files.  */
 
 
-/* Insert the content of "etc_file.file_entry" into "fe" if there is no
-   group specified.  */
-size_t insert_nogroup(struct file_entry **fe, econf_file *ef);
-
-/* Merge contents from existing usr_file groups */
-size_t merge_existing_groups(struct file_entry **fe, econf_file *uf, econf_file *ef,
-                             const size_t etc_start);
-
-/* Add entries from etc_file exclusive groups */
-size_t add_new_groups(struct file_entry **fe, econf_file *uf, econf_file *ef,
-                      const size_t merge_length);
-
 /* Returns the default dirs to iterate through when merging */
 char **get_default_dirs(const char *usr_conf_dir, const char *etc_conf_dir);
 
-/* Receives a list of config directories to look for and calls 'check_conf_dir' */
-econf_file **traverse_conf_dirs(econf_file **key_files, const char *conf_dirs[],
-                              size_t *size, const char *path, 
-                              const char *config_suffix,
-                              const char *delim, const char *comment);
+/* Called by foreach_conf_file() for every config file. main_file is true
+   for <project_name>.<suffix> itself, false for the files in the drop-in
+   directories.  */
+typedef econf_err (*conf_file_fct)(const char *path, bool main_file, void *arg);
+
+/* Call fct for every config file in the order econf_readDirs() merges
+   them: /etc/<project_name>.<suffix> or, if it does not exist,
+   <dist_conf_dir>/<project_name>.<suffix>, followed by the drop-in files.
+   An error returned for a main file other than ECONF_NOFILE stops the
+   traversal, drop-in files which fail are skipped. Returns ECONF_NOFILE
+   if fct succeeded for no file at all.  */
+econf_err foreach_conf_file(const char *dist_conf_dir,
+                            const char *etc_conf_dir,
+                            const char *project_name,
+                            const char *config_suffix,
+                            conf_file_fct fct, void *arg);
+
+/* Merge length econf_files into a new one in a single pass. Layer 0 is
+   taken as it is. Keys of later files override the value of a key of an
+   earlier one, are appended to the first part of their group if it exists
+   or are added with their group after all others. Keys without group are
+   always put first. Of duplicate keys in a later file the last one
+   overrides a key merged before, while a key new in that file gets its
+   first value, as the getters of that file return it.
+   The merged file shares the strings of the layers. If steal is not NULL,
+   the strings of every layer with steal[i] set are moved into it instead;
+   such a layer is only fit for being freed afterwards. The strings of
+   frozen layers are always copied. With fold_case group and key names
+   are matched ignoring ASCII case and the merged file is case
+   insensitive, see ECONF_CASE_INSENSITIVE.  */
+econf_err merge_files(econf_file **key_files, size_t length,
+                      const bool *steal, bool fold_case,
+                      econf_file **merged_file);
 
-/* Merge an array of given econf_files into one */
-econf_err merge_econf_files(econf_file **key_files, econf_file **merged_files);
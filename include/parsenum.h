@@ -0,0 +1,50 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+/* --- parsenum.h --- */
+
+#include "libeconf.h"
+
+/* This file contains the declaration of the functions used to convert
+   values into numbers. They accept decimal numbers only, independent of
+   the current locale, and check the whole string: surrounding blanks are
+   ignored, anything else which is not part of the number results in
+   ECONF_PARSE_ERROR. Empty strings and NULL result in ECONF_EMPTYKEY.  */
+
+
+/* Convert string into a signed integer and check that it is within
+   min and max. Accepts an optional sign followed by digits.  */
+econf_err parse_signed(const char *string, int64_t min, int64_t max,
+                       int64_t *result);
+
+/* Convert string into an unsigned integer and check that it is not
+   larger than max. Accepts an optional '+' followed by digits.  */
+econf_err parse_unsigned(const char *string, uint64_t max, uint64_t *result);
+
+/* Convert string into a floating point number. Accepts an optional sign,
+   digits with an optional '.' and fraction, an optional exponent, as well
+   as "inf", "infinity" and "nan". Values too large for the type result in
+   ECONF_PARSE_ERROR.  */
+econf_err parse_double(const char *string, double *result);
+econf_err parse_float(const char *string, float *result);
@@ -0,0 +1,75 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+/* --- sources.h --- */
+
+#include "keyfile.h"
+
+#include <sys/stat.h>
+
+/* This file contains the declaration of the functions keeping track of
+   the files econf_readDirs() read, so that econf_refresh() has to parse
+   only the files which changed since.  */
+
+
+/* A parsed file together with the stat data it was read with. layer has
+   no index, it is only used as input of merge_files().  */
+struct econf_source {
+  econf_file *layer;
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  struct timespec mtime, ctime;
+};
+
+/* The arguments of econf_readDirs() and the files found, in merge order.
+   dirty is set while the files differ from what the merged file was built
+   from.  */
+struct econf_sources {
+  char *dist_conf_dir, *etc_conf_dir, *project_name, *config_suffix;
+  char *delim, *comment;
+  struct econf_source *files;
+  size_t length;
+  bool dirty;
+};
+
+/* Remember the arguments of econf_readDirs(), no file is read yet */
+econf_err sources_new(struct econf_sources **result,
+                      const char *dist_conf_dir, const char *etc_conf_dir,
+                      const char *project_name, const char *config_suffix,
+                      const char *delim, const char *comment);
+
+/* Look for the configuration files again. Files which are new or whose
+   stat data changed are parsed, files which are gone are dropped.
+   *changed is set if the merged file has to be built again. On error
+   sources is left as it was.  */
+econf_err sources_scan(struct econf_sources *sources, bool *changed);
+
+/* Merge the files into a new econf_file and clear dirty. With steal set
+   the strings of the files are moved into it, sources is only fit for
+   sources_free() afterwards.  */
+econf_err sources_merge(struct econf_sources *sources, econf_file **merged,
+                        bool steal);
+
+void sources_free(struct econf_sources *sources);
@@ -37,7 +37,9 @@ static const char *messages[] = {
   "Key not found", /* ECONF_NOKEY */
   "Key has empty value", /* ECONF_EMPTYKEY */
   "Error creating or writing to a file", /* ECONF_WRITEERROR */
-  "Parse error" /* ECONF_PARSE_ERROR */
+  "Parse error", /* ECONF_PARSE_ERROR */
+  "Handle or iterator is outdated", /* ECONF_INVALID_HANDLE */
+  "File is frozen" /* ECONF_FROZEN */
 };
 
 const char *
@@ -25,6 +25,7 @@
 #include "../include/defines.h"
 #include "../include/getfilecontents.h"
 #include "../include/helpers.h"
+#include "../include/keyindex.h"
 
 #include <errno.h>
 #include <stdio.h>
@@ -33,9 +34,11 @@
 #include <ctype.h>
 
 static econf_err
-store (econf_file *ef, const char *group, const char *key,
+store (void *arg, const char *group, const char *key,
        const char *value, uint64_t line_number)
 {
+  econf_file *ef = arg;
+
   if (ef->alloc_length == ef->length) {
     struct file_entry *tmp;
 
@@ -48,23 +51,23 @@ store (econf_file *ef, const char *group, const char *key,
   }
 
   ef->file_entry[ef->length-1].line_number = line_number;
-
-  if (group)
-    ef->file_entry[ef->length-1].group = strdup(group);
-  else
-    ef->file_entry[ef->length-1].group = strdup(KEY_FILE_NULL_VALUE);
-
-  if (key)
-    ef->file_entry[ef->length-1].key = strdup(key);
-  else
-    ef->file_entry[ef->length-1].key = strdup(KEY_FILE_NULL_VALUE);
-
-  if (value)
-    ef->file_entry[ef->length-1].value = strdup(value);
+  ef->file_entry[ef->length-1].source = 0;
+  ef->file_entry[ef->length-1].cache_type = CACHE_NONE;
+
+  struct file_entry *fe = &ef->file_entry[ef->length-1];
+  if (!group)
+    group = KEY_FILE_NULL_VALUE;
+  // All entries of a group section share one group name
+  if (ef->length > 1 && fe[-1].group && !strcmp(fe[-1].group, group))
+    fe->group = refstr_ref(fe[-1].group);
   else
-    ef->file_entry[ef->length-1].value = NULL;
+    fe->group = refstr_new(group);
+  fe->key = refstr_new(key ? key : KEY_FILE_NULL_VALUE);
+  fe->value = refstr_new(value);
+  if (!fe->group || !fe->key || (value && !fe->value))
+    return ECONF_NOMEM;
 
-  return ECONF_SUCCESS;
+  return index_add(ef, ef->length-1);
 }
 
 static void
@@ -85,8 +88,8 @@ check_delim(const char *str, bool *has_wsp, bool *has_nonwsp)
 
 /* Read the file line by line and parse for comments, keys and values */
 econf_err
-read_file(econf_file *ef, const char *file,
-	  const char *delim, const char *comment)
+parse_file(const char *file, const char *delim, const char *comment,
+	   store_fct store_entry, void *arg)
 {
   char buf[BUFSIZ];
   char *current_group = NULL;
@@ -100,13 +103,6 @@ read_file(econf_file *ef, const char *file,
 
   check_delim(delim, &has_wsp, &has_nonwsp);
 
-  ef->path = strdup (file);
-  if (ef->path == NULL) {
-    fclose (kf);
-    return ECONF_NOMEM;
-  }
-  ef->delimiter = *delim;
-
   while (fgets(buf, sizeof(buf), kf)) {
     char *p, *name, *data = NULL;
     bool quote_seen = false, delim_seen = false;
@@ -236,7 +232,7 @@ read_file(econf_file *ef, const char *file,
 	*(p + 1) = '\0';
     }
 
-    retval = store(ef, current_group, name, data, line);
+    retval = store_entry(arg, current_group, name, data, line);
     if (retval)
       goto out;
   }
@@ -248,3 +244,18 @@ read_file(econf_file *ef, const char *file,
 
   return retval;
 }
+
+/* Read the file into ef */
+econf_err
+read_file(econf_file *ef, const char *file,
+	  const char *delim, const char *comment)
+{
+  ef->path = refstr_new (file);
+  ef->paths = malloc (sizeof(char *));
+  if (ef->path == NULL || ef->paths == NULL)
+    return ECONF_NOMEM;
+  ef->paths[ef->path_length++] = refstr_ref (ef->path);
+  ef->delimiter = *delim;
+
+  return parse_file(file, delim, comment, store, ef);
+}
@@ -0,0 +1,159 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "libeconf.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Readers register in readers[epoch & 1] while they use a snapshot. A
+// publisher flips the epoch after swapping current and waits until the
+// counter of the old epoch drops to zero; only then nobody can use the
+// old snapshot any more. Each counter has its own cache line, so readers
+// of different epochs do not contend.
+struct econf_handle {
+  econf_file *current;
+  uint64_t epoch;
+  struct {
+    uint64_t count;
+  } __attribute__((aligned(64))) readers[2];
+  // Serializes publishers. A spinning flag instead of a mutex, so that
+  // econf_handle does not need -pthread.
+  bool publishing;
+  char *dist_conf_dir, *etc_conf_dir, *project_name, *config_suffix;
+  char *delim, *comment;
+};
+
+// strdup() which keeps NULL
+static econf_err copy_param(char **dest, const char *src) {
+  *dest = NULL;
+  if (src && (*dest = strdup(src)) == NULL)
+    return ECONF_NOMEM;
+  return ECONF_SUCCESS;
+}
+
+econf_err econf_newHandle(econf_handle **result, const char *dist_conf_dir,
+                          const char *etc_conf_dir, const char *project_name,
+                          const char *config_suffix, const char *delim,
+                          const char *comment) {
+  if (result == NULL || config_suffix == NULL || !*config_suffix ||
+      project_name == NULL || !*project_name || delim == NULL)
+    return ECONF_ERROR;
+
+  econf_handle *h = calloc(1, sizeof(econf_handle));
+  if (h == NULL)
+    return ECONF_NOMEM;
+
+  econf_err error;
+  if ((error = copy_param(&h->dist_conf_dir, dist_conf_dir)) ||
+      (error = copy_param(&h->etc_conf_dir, etc_conf_dir)) ||
+      (error = copy_param(&h->project_name, project_name)) ||
+      (error = copy_param(&h->config_suffix, config_suffix)) ||
+      (error = copy_param(&h->delim, delim)) ||
+      (error = copy_param(&h->comment, comment)) ||
+      (error = econf_handleReload(h))) {
+    econf_freeHandle(h);
+    return error;
+  }
+  *result = h;
+  return ECONF_SUCCESS;
+}
+
+econf_err econf_handleReload(econf_handle *h) {
+  if (!h)
+    return ECONF_ERROR;
+
+  econf_file *key_file;
+  econf_err error = econf_readDirs(&key_file, h->dist_conf_dir,
+                                   h->etc_conf_dir, h->project_name,
+                                   h->config_suffix, h->delim, h->comment);
+  if (error)
+    return error;
+  return econf_handlePublish(h, key_file);
+}
+
+econf_err econf_handlePublish(econf_handle *h, econf_file *key_file) {
+  if (!h || !key_file)
+    return ECONF_ERROR;
+
+  econf_err error = econf_freeze(key_file);
+  if (error) {
+    econf_freeFile(key_file);
+    return error;
+  }
+
+  while (__atomic_test_and_set(&h->publishing, __ATOMIC_ACQUIRE))
+    sched_yield();
+  econf_file *old = __atomic_exchange_n(&h->current, key_file,
+                                        __ATOMIC_SEQ_CST);
+  uint64_t epoch = __atomic_fetch_add(&h->epoch, 1, __ATOMIC_SEQ_CST);
+  // Grace period: readers of the old epoch may still use old
+  while (__atomic_load_n(&h->readers[epoch & 1].count, __ATOMIC_SEQ_CST))
+    sched_yield();
+  __atomic_clear(&h->publishing, __ATOMIC_RELEASE);
+
+  econf_freeFile(old);
+  return ECONF_SUCCESS;
+}
+
+econf_err econf_handleAcquire(econf_handle *h, econf_snapshot *snapshot) {
+  if (!h || snapshot == NULL)
+    return ECONF_ERROR;
+
+  // Retry if a publisher flipped the epoch in between, it might not wait
+  // for the counter incremented here.
+  for (;;) {
+    uint64_t epoch = __atomic_load_n(&h->epoch, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&h->readers[epoch & 1].count, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&h->epoch, __ATOMIC_SEQ_CST) == epoch) {
+      snapshot->epoch = epoch;
+      break;
+    }
+    __atomic_sub_fetch(&h->readers[epoch & 1].count, 1, __ATOMIC_SEQ_CST);
+  }
+  snapshot->file = __atomic_load_n(&h->current, __ATOMIC_SEQ_CST);
+  return ECONF_SUCCESS;
+}
+
+void econf_handleRelease(econf_handle *h, econf_snapshot *snapshot) {
+  if (!h || snapshot == NULL || snapshot->file == NULL)
+    return;
+
+  __atomic_sub_fetch(&h->readers[snapshot->epoch & 1].count, 1,
+                     __ATOMIC_SEQ_CST);
+  snapshot->file = NULL;
+}
+
+void econf_freeHandle(econf_handle *h) {
+  if (!h)
+    return;
+
+  econf_freeFile(h->current);
+  free(h->dist_conf_dir);
+  free(h->etc_conf_dir);
+  free(h->project_name);
+  free(h->config_suffix);
+  free(h->delim);
+  free(h->comment);
+  free(h);
+}
@@ -24,13 +24,56 @@
 #include "libeconf.h"
 #include "../include/defines.h"
 #include "../include/helpers.h"
+#include "../include/keyindex.h"
 
-#include <ctype.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 
+struct refstr {
+  size_t refs;
+  char str[];
+};
+
+static struct refstr *refstr_header(char *string) {
+  return (struct refstr *) (string - offsetof(struct refstr, str));
+}
+
+// Room for length characters and the terminator, the caller fills it
+static char *refstr_alloc(size_t length) {
+  struct refstr *rs = malloc(sizeof(struct refstr) + length + 1);
+  if (rs == NULL)
+    return NULL;
+  rs->refs = 1;
+  return rs->str;
+}
+
+char *refstr_new(const char *string) {
+  if (string == NULL)
+    return NULL;
+  size_t length = strlen(string);
+  char *ret = refstr_alloc(length);
+  if (ret != NULL)
+    memcpy(ret, string, length + 1);
+  return ret;
+}
+
+char *refstr_ref(char *string) {
+  if (string != NULL)
+    __atomic_fetch_add(&refstr_header(string)->refs, 1, __ATOMIC_RELAXED);
+  return string;
+}
+
+void refstr_unref(char *string) {
+  if (string == NULL)
+    return;
+  struct refstr *rs = refstr_header(string);
+  if (__atomic_sub_fetch(&rs->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    free(rs);
+}
+
 // Combine file path and file name
 char *combine_strings(const char *string_one, const char *string_two,
                       const char delimiter) {
@@ -40,11 +83,31 @@ char *combine_strings(const char *string_one, const char *string_two,
   return combined;
 }
 
+void move_file_contents(econf_file *dst, econf_file *src) {
+  econf_file old = *dst;
+  *dst = *src;
+  dst->path = old.path;
+  dst->on_merge_delete = old.on_merge_delete;
+  dst->sources = old.sources;
+  dst->count_lookups = old.count_lookups;
+  dst->lookup_hits = old.lookup_hits;
+  dst->lookup_misses = old.lookup_misses;
+  dst->lookup_filtered = old.lookup_filtered;
+  dst->lookup_perfect = old.lookup_perfect;
+  old.path = NULL;
+  old.sources = NULL;
+  *src = old;
+  econf_freeFile(src);
+}
+
 // Set null value defined in include/defines.h
 void initialize(econf_file *key_file, size_t num) {
-  key_file->file_entry[num].group = strdup(KEY_FILE_NULL_VALUE);
-  key_file->file_entry[num].key = strdup(KEY_FILE_NULL_VALUE);
-  key_file->file_entry[num].value = strdup(KEY_FILE_NULL_VALUE);
+  key_file->file_entry[num].group = refstr_new(KEY_FILE_NULL_VALUE);
+  key_file->file_entry[num].key = refstr_new(KEY_FILE_NULL_VALUE);
+  key_file->file_entry[num].value = refstr_new(KEY_FILE_NULL_VALUE);
+  key_file->file_entry[num].line_number = 0;
+  key_file->file_entry[num].source = KEY_FILE_NO_SOURCE;
+  key_file->file_entry[num].cache_type = CACHE_NONE;
 }
 
 // Remove whitespace from beginning and end, append string terminator
@@ -103,7 +166,9 @@ char *stripbrackets(char *string) {
 char *addbrackets(const char *string) {
   size_t length = strlen(string);
   if (!(*string == '[' && string[length - 1] == ']')) {
-    char *buffer = malloc(length + 3);
+    char *buffer = refstr_alloc(length + 2);
+    if (buffer == NULL)
+      return NULL;
     char *cp = buffer;
     *cp++ = '[';
     cp = stpcpy (cp, string);
@@ -111,50 +176,58 @@ char *addbrackets(const char *string) {
     *cp = '\0';
     return buffer;
   }
-  return strdup(string);
+  return refstr_new(string);
 }
 
-// Turn the given string into lower case
-char *toLowerCase(char *string) {
-  char *ptr = string;
-  while (*string)
-    {
-      *string = tolower(*string);
-      string++;
-    }
-  return ptr;
+// Lower case of an ASCII character, independent of the locale
+static char fold(char c) {
+  return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
 }
 
-// Turn the given string into a hash value
-// Hash function djb2 from Dan J. Bernstein
-size_t hashstring(const char *string) {
-  size_t hash = 5381;
-  char c;
-  while ((c = *string++)) { hash = ((hash << 5) + hash) + c; }
-  return hash;
+// Compare the first length characters of a and b
+static bool equal_n(const char *a, const char *b, size_t length,
+                    bool fold_case) {
+  if (!fold_case)
+    return !strncmp(a, b, length);
+  for (size_t i = 0; i < length; i++) {
+    if (fold(a[i]) != fold(b[i]))
+      return false;
+    if (!a[i])
+      break;
+  }
+  return true;
+}
+
+bool names_equal(const char *a, const char *b, bool fold_case) {
+  if (!fold_case)
+    return !strcmp(a, b);
+  for (; fold(*a) == fold(*b); a++, b++)
+    if (!*a)
+      return true;
+  return false;
+}
+
+// Check whether the stored group name matches the group given by the
+// caller. NULL or "" selects the entries without a group, "name" and
+// "[name]" both select "[name]". No bracketed copy of group is created.
+bool group_matches(const char *stored, const char *group, bool fold_case) {
+  if (!group || !*group)
+    return !strcmp(stored, KEY_FILE_NULL_VALUE);
+
+  size_t length = strlen(group);
+  if (*group == '[' && group[length - 1] == ']')
+    return names_equal(stored, group, fold_case);
+
+  return *stored == '[' && equal_n(stored + 1, group, length, fold_case) &&
+         stored[length + 1] == ']' && stored[length + 2] == '\0';
 }
 
 // Look for matching key
-econf_err find_key(econf_file key_file, const char *group, const char *key, size_t *num) {
-  char *grp = (!group || !*group) ? strdup(KEY_FILE_NULL_VALUE) :
-               addbrackets(group);
-  if (grp == NULL)
-    return  ECONF_NOMEM;
-  if (!key || !*key) {
-    free(grp);
+econf_err find_key(econf_file *key_file, const char *group, const char *key, size_t *num) {
+  if (!key || !*key)
     return ECONF_ERROR;
-  }
-  for (size_t i = 0; i < key_file.length; i++) {
-    if (!strcmp(key_file.file_entry[i].group, grp) &&
-        !strcmp(key_file.file_entry[i].key, key)) {
-      free(grp);
-      *num = i;
-      return ECONF_SUCCESS;
-    }
-  }
-  // Key not found
-  free(grp);
-  return ECONF_NOKEY;
+
+  return index_find_key(key_file, group, key, num);
 }
 
 // Append a new key to an existing econf_file
@@ -163,25 +236,36 @@ econf_err find_key(econf_file key_file, const char *group, const char *key, size
 static econf_err
 new_key (econf_file *key_file, const char *group, const char *key) {
   econf_err error;
-  char *grp = (!group || !*group) ? strdup(KEY_FILE_NULL_VALUE) :
-               addbrackets(group);
+  if (key_file == NULL || key == NULL)
+    return ECONF_ERROR;
+
+  // Share the name of an existing group, it is spelled the same unless
+  // the case is ignored
+  struct econf_group *existing = key_file->fold_case ? NULL :
+                                 index_find_group(key_file, group);
+  char *grp = existing ?
+              refstr_ref(key_file->file_entry[existing->keys[0]].group) :
+              (!group || !*group) ? refstr_new(KEY_FILE_NULL_VALUE) :
+              addbrackets(group);
   if (grp == NULL)
     return ECONF_NOMEM;
-  if (key_file == NULL || key == NULL)
-    {
-      free(grp);
-      return ECONF_ERROR;
-    }
   if ((error = key_file_append(key_file))) {
-    free(grp);
+    refstr_unref(grp);
     return error;
   }
-  if ((error = setGroup(key_file, key_file->length - 1, grp))) {
-    free(grp);
+  // Hand the bracketed name over instead of copying it once more
+  refstr_unref(key_file->file_entry[key_file->length - 1].group);
+  key_file->file_entry[key_file->length - 1].group = grp;
+  if ((error = setKey(key_file, key_file->length - 1, key)) ||
+      (error = index_add(key_file, key_file->length - 1))) {
+    struct file_entry *fe = &key_file->file_entry[--key_file->length];
+    refstr_unref(fe->group);
+    refstr_unref(fe->key);
+    refstr_unref(fe->value);
+    memset(fe, 0, sizeof(*fe));
     return error;
   }
-  free(grp);
-  return setKey(key_file, key_file->length - 1, key);
+  return ECONF_SUCCESS;
 }
 
 // Set value for the given group, key combination. If the combination
@@ -193,7 +277,9 @@ econf_err setKeyValue(econf_err (*function) (econf_file*, size_t, const void*),
 		      const void *value)
 {
   size_t num;
-  econf_err error = find_key(*kf, group, key, &num);
+  if (kf->frozen)
+    return ECONF_FROZEN;
+  econf_err error = find_key(kf, group, key, &num);
   if (error) {
     if (error != ECONF_NOKEY) {
       return error;
@@ -203,16 +289,11 @@ econf_err setKeyValue(econf_err (*function) (econf_file*, size_t, const void*),
     }
     num = kf->length - 1;
   }
-  return function(kf, num, value);
-}
-
-struct file_entry cpy_file_entry(struct file_entry fe) {
-  struct file_entry copied_fe;
-  copied_fe.group = strdup(fe.group);
-  copied_fe.key = strdup(fe.key);
-  if (fe.value)
-    copied_fe.value = strdup(fe.value);
-  else
-    copied_fe.value = NULL;
-  return copied_fe;
+  new_generation(kf);
+  if ((error = function(kf, num, value)))
+    return error;
+  // The value doesn't come from a file any more
+  kf->file_entry[num].source = KEY_FILE_NO_SOURCE;
+  kf->file_entry[num].line_number = 0;
+  return ECONF_SUCCESS;
 }
@@ -25,6 +25,7 @@
 #include "../include/defines.h"
 #include "../include/helpers.h"
 #include "../include/keyfile.h"
+#include "../include/parsenum.h"
 
 #include <errno.h>
 #include <float.h>
@@ -33,6 +34,12 @@
 #include <stdio.h>
 #include <string.h>
 
+void new_generation(econf_file *kf) {
+  static uint64_t generation_counter = 0;
+
+  kf->generation = __atomic_add_fetch(&generation_counter, 1, __ATOMIC_RELAXED);
+}
+
 econf_err key_file_append(econf_file *kf) {
   /* XXX check return values and for NULL pointers */
   if(kf->length++ >= kf->alloc_length) {
@@ -46,37 +53,149 @@ econf_err key_file_append(econf_file *kf) {
 
 /* --- GETTERS --- */
 
-/* XXX all get*ValueNum functions are missing error handling */
-econf_err getIntValueNum(econf_file key_file, size_t num, int32_t *result) {
-  *result = strtol(key_file.file_entry[num].value, NULL, 10);
-  return ECONF_SUCCESS;
+/* Functions converting the stored string into the requested type.
+   See parsenum.h for the accepted syntax.  */
+static econf_err parseInt(const char *string, int32_t *result) {
+  int64_t value;
+  econf_err error = parse_signed(string, INT32_MIN, INT32_MAX, &value);
+  if (error == ECONF_SUCCESS)
+    *result = value;
+  return error;
 }
 
-econf_err getInt64ValueNum(econf_file key_file, size_t num, int64_t *result) {
-  *result = strtoll(key_file.file_entry[num].value, NULL, 10);
-  return ECONF_SUCCESS;
+static econf_err parseInt64(const char *string, int64_t *result) {
+  return parse_signed(string, INT64_MIN, INT64_MAX, result);
 }
 
-econf_err getUIntValueNum(econf_file key_file, size_t num, uint32_t *result) {
-  *result = strtoul(key_file.file_entry[num].value, NULL, 10);
-  return ECONF_SUCCESS;
+static econf_err parseUInt(const char *string, uint32_t *result) {
+  uint64_t value;
+  econf_err error = parse_unsigned(string, UINT32_MAX, &value);
+  if (error == ECONF_SUCCESS)
+    *result = value;
+  return error;
 }
 
-econf_err getUInt64ValueNum(econf_file key_file, size_t num, uint64_t *result) {
-  *result = strtoull(key_file.file_entry[num].value, NULL, 10);
-  return ECONF_SUCCESS;
+static econf_err parseUInt64(const char *string, uint64_t *result) {
+  return parse_unsigned(string, UINT64_MAX, result);
 }
 
-econf_err getFloatValueNum(econf_file key_file, size_t num, float *result) {
-  *result = strtof(key_file.file_entry[num].value, NULL);
-  return ECONF_SUCCESS;
+static econf_err parseFloat(const char *string, float *result) {
+  return parse_float(string, result);
+}
+
+static econf_err parseDouble(const char *string, double *result) {
+  return parse_double(string, result);
+}
+
+static char lower(char c) {
+  return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// Compare string case insensitively with the lower case ASCII token
+static bool equal_token(const char *string, const char *token) {
+  for (; *token; string++, token++)
+    if (lower(*string) != *token)
+      return false;
+  return !*string;
+}
+
+// Match string against the values accepted for booleans ("1", "yes",
+// "true", "0", "no", "false" and the empty string) in a single pass.
+// Returns the canonical form "true" or "false", NULL for other strings.
+static const char *bool_token(const char *string) {
+  if (!*string)
+    return "false";
+  switch (lower(*string)) {
+  case '1':
+    return string[1] ? NULL : "true";
+  case '0':
+    return string[1] ? NULL : "false";
+  case 'y':
+    return equal_token(string + 1, "es") ? "true" : NULL;
+  case 't':
+    return equal_token(string + 1, "rue") ? "true" : NULL;
+  case 'n':
+    return equal_token(string + 1, "o") ? "false" : NULL;
+  case 'f':
+    return equal_token(string + 1, "alse") ? "false" : NULL;
+  default:
+    return NULL;
+  }
 }
 
-econf_err getDoubleValueNum(econf_file key_file, size_t num, double *result) {
-  *result = strtod(key_file.file_entry[num].value, NULL);
+static econf_err parseBool(const char *string, bool *result) {
+  if (!string)
+    return ECONF_EMPTYKEY;
+
+  const char *token = bool_token(string);
+  if (!token)
+    return ECONF_PARSE_ERROR;
+  *result = (*token == 't');
   return ECONF_SUCCESS;
 }
 
+econf_err parseValue(econf_type type, const char *value, void *result) {
+  switch (type) {
+  case ECONF_TYPE_INT:
+    return parseInt(value, result);
+  case ECONF_TYPE_INT64:
+    return parseInt64(value, result);
+  case ECONF_TYPE_UINT:
+    return parseUInt(value, result);
+  case ECONF_TYPE_UINT64:
+    return parseUInt64(value, result);
+  case ECONF_TYPE_FLOAT:
+    return parseFloat(value, result);
+  case ECONF_TYPE_DOUBLE:
+    return parseDouble(value, result);
+  case ECONF_TYPE_STRING:
+    if (value == NULL)
+      *(char **) result = NULL;
+    else if ((*(char **) result = strdup(value)) == NULL)
+      return ECONF_NOMEM;
+    return ECONF_SUCCESS;
+  case ECONF_TYPE_BOOL:
+    return parseBool(value, result);
+  }
+  return ECONF_ERROR;
+}
+
+/* The get*ValueNum functions parse the value on the first call for a
+   type and keep the result in the cache of the entry. Further calls for
+   the same type only return the cached result. The setters reset it.
+   Getters may run concurrently on a file which is not modified: the
+   cache is only filled while empty, by the thread which claimed it with
+   CACHE_BUSY, and published with a release store of its type. A value
+   read as another type than the cached one is parsed on every call, as
+   is any value of a frozen file which has not been cached before
+   econf_freeze().  */
+#define econf_getValueNum(FCT_TYPE, TYPE, FIELD, CACHE_TYPE)		\
+econf_err get ## FCT_TYPE ## ValueNum(econf_file key_file, size_t num, TYPE *result) { \
+  struct file_entry *fe = &key_file.file_entry[num]; \
+  enum cache_type cached = __atomic_load_n(&fe->cache_type, __ATOMIC_ACQUIRE); \
+\
+  if (cached != CACHE_TYPE) { \
+    if (key_file.frozen || cached != CACHE_NONE || \
+        !__atomic_compare_exchange_n(&fe->cache_type, &cached, CACHE_BUSY, \
+                                     false, __ATOMIC_ACQUIRE, \
+                                     __ATOMIC_RELAXED)) \
+      return parse ## FCT_TYPE(fe->value, result); \
+    fe->cache_error = parse ## FCT_TYPE(fe->value, &fe->cache.FIELD); \
+    __atomic_store_n(&fe->cache_type, CACHE_TYPE, __ATOMIC_RELEASE); \
+  } \
+  if (fe->cache_error == ECONF_SUCCESS) \
+    *result = fe->cache.FIELD; \
+  return fe->cache_error; \
+}
+
+econf_getValueNum(Int, int32_t, i32, CACHE_INT)
+econf_getValueNum(Int64, int64_t, i64, CACHE_INT64)
+econf_getValueNum(UInt, uint32_t, u32, CACHE_UINT)
+econf_getValueNum(UInt64, uint64_t, u64, CACHE_UINT64)
+econf_getValueNum(Float, float, f, CACHE_FLOAT)
+econf_getValueNum(Double, double, d, CACHE_DOUBLE)
+econf_getValueNum(Bool, bool, b, CACHE_BOOL)
+
 econf_err getStringValueNum(econf_file key_file, size_t num, char **result) {
   if (key_file.file_entry[num].value)
     *result = strdup(key_file.file_entry[num].value);
@@ -86,33 +205,13 @@ econf_err getStringValueNum(econf_file key_file, size_t num, char **result) {
   return ECONF_SUCCESS;
 }
 
-econf_err getBoolValueNum(econf_file key_file, size_t num, bool *result) {
-  char *value, *tmp;
-  tmp = strdup(key_file.file_entry[num].value);
-  value = toLowerCase(tmp);
-  size_t hash = hashstring(toLowerCase(key_file.file_entry[num].value));
-  econf_err err = ECONF_SUCCESS;
-
-  if ((*value == '1' && strlen(tmp) == 1) || hash == YES || hash == TRUE)
-    *result = true;
-  else if ((*value == '0' && strlen(tmp) == 1) || !*value ||
-	   hash == NO || hash == FALSE)
-    *result = false;
-  else
-    err = ECONF_PARSE_ERROR;
-
-  free(tmp);
-  return err;
-}
-
 /* --- SETTERS --- */
 
 econf_err setGroup(econf_file *key_file, size_t num, const char *value) {
   if (key_file == NULL || value == NULL)
     return ECONF_ERROR;
-  if (key_file->file_entry[num].group)
-    free(key_file->file_entry[num].group);
-  key_file->file_entry[num].group = strdup(value);
+  refstr_unref(key_file->file_entry[num].group);
+  key_file->file_entry[num].group = refstr_new(value);
   if (key_file->file_entry[num].group == NULL)
     return ECONF_NOMEM;
 
@@ -122,9 +221,8 @@ econf_err setGroup(econf_file *key_file, size_t num, const char *value) {
 econf_err setKey(econf_file *key_file, size_t num, const char *value) {
   if (key_file == NULL || value == NULL)
     return ECONF_ERROR;
-  if (key_file->file_entry[num].key)
-    free(key_file->file_entry[num].key);
-  key_file->file_entry[num].key = strdup(value);
+  refstr_unref(key_file->file_entry[num].key);
+  key_file->file_entry[num].key = refstr_new(value);
   if (key_file->file_entry[num].key == NULL)
     return ECONF_NOMEM;
 
@@ -135,15 +233,16 @@ econf_err setKey(econf_file *key_file, size_t num, const char *value) {
 #define econf_setValueNum(FCT_TYPE, TYPE, FMT, PR)			\
 econf_err set ## FCT_TYPE ## ValueNum(econf_file *ef, size_t num, const void *v) { \
   const TYPE *value = (const TYPE*) v; \
-  char *ptr; \
+  char buf[64], *ptr; \
 \
-  if (asprintf (&ptr, FMT PR, *value) == -1) \
+  snprintf (buf, sizeof(buf), FMT PR, *value); \
+  if ((ptr = refstr_new (buf)) == NULL) \
     return ECONF_NOMEM; \
 \
-  if (ef->file_entry[num].value) \
-    free(ef->file_entry[num].value); \
+  refstr_unref(ef->file_entry[num].value); \
 \
   ef->file_entry[num].value = ptr; \
+  ef->file_entry[num].cache_type = CACHE_NONE; \
 \
   return ECONF_SUCCESS; \
 }
@@ -161,36 +260,31 @@ econf_err setStringValueNum(econf_file *ef, size_t num, const void *v) {
   const char *value = (const char*) (v ? v : "");
   char *ptr;
 
-  if ((ptr = strdup (value)) == NULL)
+  if ((ptr = refstr_new (value)) == NULL)
     return ECONF_NOMEM;
 
-  if (ef->file_entry[num].value)
-    free(ef->file_entry[num].value);
+  refstr_unref(ef->file_entry[num].value);
 
   ef->file_entry[num].value = ptr;
+  ef->file_entry[num].cache_type = CACHE_NONE;
 
   return ECONF_SUCCESS;
 }
 
-/* XXX This needs to be optimised and error checking added */
 econf_err setBoolValueNum(econf_file *kf, size_t num, const void *v) {
   const char *value = (const char*) (v ? v : "");
-  econf_err error = ECONF_SUCCESS;
-  char *tmp = strdup(value);
-  size_t hash = hashstring(toLowerCase(tmp));
-
-  if ((*value == '1' && strlen(tmp) == 1) || hash == YES || hash == TRUE) {
-    free(kf->file_entry[num].value);
-    kf->file_entry[num].value = strdup("true");
-  } else if ((*value == '0' && strlen(tmp) == 1) || !*value ||
-             hash == NO || hash == FALSE) {
-    free(kf->file_entry[num].value);
-    kf->file_entry[num].value = strdup("false");
-  } else if (hash == KEY_FILE_NULL_VALUE_HASH) {
-    free(kf->file_entry[num].value);
-    kf->file_entry[num].value = strdup(KEY_FILE_NULL_VALUE);
-  } else { error = ECONF_ERROR; }
-
-  free(tmp);
-  return error;
+  const char *token = bool_token(value);
+  char *tmp;
+
+  if (!token && equal_token(value, KEY_FILE_NULL_VALUE))
+    token = KEY_FILE_NULL_VALUE;
+  if (!token)
+    return ECONF_ERROR;
+  if (!(tmp = refstr_new(token)))
+    return ECONF_NOMEM;
+
+  refstr_unref(kf->file_entry[num].value);
+  kf->file_entry[num].value = tmp;
+  kf->file_entry[num].cache_type = CACHE_NONE;
+  return ECONF_SUCCESS;
 }
@@ -0,0 +1,560 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "libeconf.h"
+#include "../include/defines.h"
+#include "../include/helpers.h"
+#include "../include/keyindex.h"
+
+#include <string.h>
+
+// Hash function djb2 from Dan J. Bernstein, continued from hash. With
+// fold_case the string is hashed as if it were in lower case (ASCII).
+static uint64_t hash_bytes(uint64_t hash, const char *string, size_t length,
+                           bool fold_case) {
+  for (size_t i = 0; i < length; i++) {
+    unsigned char c = string[i];
+    if (fold_case && c >= 'A' && c <= 'Z')
+      c += 'a' - 'A';
+    hash = ((hash << 5) + hash) + c;
+  }
+  return hash;
+}
+
+// Hash the group name the way addbrackets() would store it, but without
+// the brackets. NULL or "" stands for no group and hashes as "".
+static uint64_t group_hash(const char *group, bool fold_case) {
+  if (!group || !*group)
+    return hash_bytes(5381, "", 0, false);
+  size_t length = strlen(group);
+  if (*group == '[' && group[length - 1] == ']')
+    return hash_bytes(5381, group + 1, length - 2, fold_case);
+  return hash_bytes(5381, group, length, fold_case);
+}
+
+// Stored groups use KEY_FILE_NULL_VALUE for no group
+static const char *stored_group(const char *group) {
+  return strcmp(group, KEY_FILE_NULL_VALUE) ? group : NULL;
+}
+
+uint64_t key_hash(const char *group, const char *key, bool fold_case) {
+  uint64_t hash = hash_bytes(group_hash(group, fold_case), "", 1, false);
+  return hash_bytes(hash, key, strlen(key), fold_case);
+}
+
+// Spread the bits of the djb2 hash before using it
+static uint64_t mix(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// Table slot of hash
+static size_t slot(uint64_t hash, size_t table_size) {
+  return mix(hash) & (table_size - 1);
+}
+
+// Word of the filter and the two bits in it representing hash. The word
+// is taken from the upper half of the mixed hash, the slot uses the lower.
+static uint64_t *filter_word(const econf_file *kf, uint64_t hash,
+                             uint64_t *mask) {
+  hash = mix(hash);
+  *mask = (1ULL << (hash & 63)) | (1ULL << ((hash >> 6) & 63));
+  return &kf->filter[(hash >> 32) & (kf->filter_words - 1)];
+}
+
+static void filter_add(econf_file *kf, uint64_t hash) {
+  uint64_t mask;
+  *filter_word(kf, hash, &mask) |= mask;
+}
+
+// Put value + 1 into the first free slot for hash
+static void table_insert(size_t *table, size_t table_size, uint64_t hash,
+                         size_t value) {
+  size_t pos = slot(hash, table_size);
+  while (table[pos])
+    pos = (pos + 1) & (table_size - 1);
+  table[pos] = value + 1;
+}
+
+// Double the size of the group table, keeping the load factor below 1/2
+static econf_err grow_group_table(econf_file *kf) {
+  size_t size = kf->group_table_size ? 2 * kf->group_table_size :
+                2 * KEY_FILE_DEFAULT_LENGTH;
+  size_t *table = calloc(size, sizeof(size_t));
+  if (table == NULL)
+    return ECONF_NOMEM;
+
+  for (size_t i = 0; i < kf->group_length; i++)
+    table_insert(table, size, kf->groups[i].hash, i);
+  free(kf->group_table);
+  kf->group_table = table;
+  kf->group_table_size = size;
+  return ECONF_SUCCESS;
+}
+
+// Double the size of the key table, keeping the load factor below 1/2.
+// The filter grows with it.
+static econf_err grow_key_table(econf_file *kf) {
+  size_t size = kf->key_table_size ? 2 * kf->key_table_size :
+                2 * KEY_FILE_DEFAULT_LENGTH;
+  size_t *table = calloc(size, sizeof(size_t));
+  uint64_t *filter = calloc(size / 8, sizeof(uint64_t));
+  if (table == NULL || filter == NULL) {
+    free(table);
+    free(filter);
+    return ECONF_NOMEM;
+  }
+
+  free(kf->key_table);
+  free(kf->filter);
+  kf->key_table = table;
+  kf->key_table_size = size;
+  kf->filter = filter;
+  kf->filter_words = size / 8;
+  for (size_t i = 0; i < kf->group_length; i++)
+    for (size_t j = 0; j < kf->groups[i].key_length; j++) {
+      size_t num = kf->groups[i].keys[j];
+      table_insert(table, size, kf->file_entry[num].hash, num);
+      filter_add(kf, kf->file_entry[num].hash);
+    }
+  return ECONF_SUCCESS;
+}
+
+// Return the number of the group with the given stored name. If needed
+// the group is created.
+static econf_err add_group(econf_file *kf, const char *name, size_t *num) {
+  uint64_t hash = group_hash(stored_group(name), kf->fold_case);
+
+  if (kf->group_table_size) {
+    size_t pos = slot(hash, kf->group_table_size);
+    while (kf->group_table[pos]) {
+      struct econf_group *grp = &kf->groups[kf->group_table[pos] - 1];
+      if (grp->hash == hash && names_equal(grp->name, name, kf->fold_case)) {
+        *num = kf->group_table[pos] - 1;
+        return ECONF_SUCCESS;
+      }
+      pos = (pos + 1) & (kf->group_table_size - 1);
+    }
+  }
+
+  if (kf->group_length == kf->group_alloc_length) {
+    size_t length = kf->group_alloc_length ? 2 * kf->group_alloc_length :
+                    KEY_FILE_DEFAULT_LENGTH;
+    struct econf_group *tmp = realloc(kf->groups,
+                                      length * sizeof(struct econf_group));
+    if (tmp == NULL)
+      return ECONF_NOMEM;
+    kf->groups = tmp;
+    kf->group_alloc_length = length;
+  }
+  if (2 * (kf->group_length + 1) > kf->group_table_size) {
+    econf_err error = grow_group_table(kf);
+    if (error)
+      return error;
+  }
+
+  struct econf_group *grp = &kf->groups[kf->group_length];
+  grp->name = name;
+  grp->hash = hash;
+  grp->keys = NULL;
+  grp->key_length = grp->key_alloc_length = 0;
+  grp->sorted = NULL;
+  table_insert(kf->group_table, kf->group_table_size, hash, kf->group_length);
+  *num = kf->group_length++;
+  return ECONF_SUCCESS;
+}
+
+econf_err index_add(econf_file *kf, size_t num) {
+  struct file_entry *fe = &kf->file_entry[num];
+  econf_err error;
+  size_t group_num;
+
+  fe->hash = key_hash(stored_group(fe->group), fe->key, kf->fold_case);
+  fe->indexed = false;
+
+  // Only the first entry of a group/key combination is indexed
+  if (kf->key_table_size) {
+    size_t pos = slot(fe->hash, kf->key_table_size);
+    while (kf->key_table[pos]) {
+      struct file_entry *other = &kf->file_entry[kf->key_table[pos] - 1];
+      if (other->hash == fe->hash &&
+          names_equal(other->key, fe->key, kf->fold_case) &&
+          names_equal(other->group, fe->group, kf->fold_case)) {
+        other->last = num;
+        return ECONF_SUCCESS;
+      }
+      pos = (pos + 1) & (kf->key_table_size - 1);
+    }
+  }
+
+  if ((error = add_group(kf, fe->group, &group_num)))
+    return error;
+  struct econf_group *grp = &kf->groups[group_num];
+  if (grp->key_length == grp->key_alloc_length) {
+    size_t length = grp->key_alloc_length ? 2 * grp->key_alloc_length :
+                    KEY_FILE_DEFAULT_LENGTH;
+    size_t *tmp = realloc(grp->keys, length * sizeof(size_t));
+    if (tmp == NULL)
+      return ECONF_NOMEM;
+    grp->keys = tmp;
+    grp->key_alloc_length = length;
+  }
+  if (2 * (kf->key_table_used + 1) > kf->key_table_size) {
+    if ((error = grow_key_table(kf)))
+      return error;
+  }
+
+  table_insert(kf->key_table, kf->key_table_size, fe->hash, num);
+  filter_add(kf, fe->hash);
+  kf->key_table_used++;
+  fe->indexed = true;
+  fe->last = num;
+  grp->keys[grp->key_length++] = num;
+  free(grp->sorted);
+  grp->sorted = NULL;
+  return ECONF_SUCCESS;
+}
+
+void index_free(econf_file *kf) {
+  for (size_t i = 0; i < kf->group_length; i++) {
+    free(kf->groups[i].keys);
+    free(kf->groups[i].sorted);
+  }
+  free(kf->groups);
+  free(kf->group_table);
+  free(kf->key_table);
+  free(kf->filter);
+  free(kf->mph.disp);
+  free(kf->mph.slots);
+  memset(&kf->mph, 0, sizeof(kf->mph));
+  kf->groups = NULL;
+  kf->group_table = kf->key_table = NULL;
+  kf->filter = NULL;
+  kf->filter_words = 0;
+  kf->group_length = kf->group_alloc_length = 0;
+  kf->group_table_size = kf->key_table_size = kf->key_table_used = 0;
+}
+
+econf_err index_build(econf_file *kf) {
+  index_free(kf);
+  for (size_t i = 0; i < kf->length; i++) {
+    econf_err error = index_add(kf, i);
+    if (error)
+      return error;
+  }
+  return ECONF_SUCCESS;
+}
+
+struct econf_group *index_find_group(econf_file *kf, const char *group) {
+  if (!kf->group_table_size)
+    return NULL;
+
+  uint64_t hash = group_hash(group, kf->fold_case);
+  size_t pos = slot(hash, kf->group_table_size);
+  while (kf->group_table[pos]) {
+    struct econf_group *grp = &kf->groups[kf->group_table[pos] - 1];
+    if (grp->hash == hash && group_matches(grp->name, group, kf->fold_case))
+      return grp;
+    pos = (pos + 1) & (kf->group_table_size - 1);
+  }
+  return NULL;
+}
+
+// Full 64 bit finalizer of MurmurHash3. Unlike mix(), which only has to
+// spread the hash over table slots, its output bits are independent
+// enough to derive a bucket and two slot values from.
+static uint64_t fmix(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// Bucket of hash and the two values its slot is computed from. The seed
+// is mixed in before the finalizer; the bucket and the slot values come
+// from two separate finalizer outputs. The values are scaled into [0, n)
+// by multiplication instead of a modulo.
+static void mph_hash(const struct econf_mph *mph, uint64_t hash,
+                     size_t *bucket, uint64_t *f1, uint64_t *f2) {
+  uint64_t h1 = fmix(hash ^ mph->seed);
+  uint64_t h2 = fmix(hash ^ (mph->seed + 0x9e3779b97f4a7c15ULL));
+  *bucket = ((h1 >> 32) * mph->buckets) >> 32;
+  *f1 = ((h2 & 0xffffffff) * mph->size) >> 32;
+  *f2 = ((h2 >> 32) * mph->size) >> 32;
+}
+
+// (f1 + d0 * f2 + d1) % size, computed by Lemire's fastmod. The sum is
+// below 2^32 since index_freeze() limits size.
+static size_t mph_slot(const struct econf_mph *mph, uint64_t f1, uint64_t f2,
+                       uint32_t d0, uint32_t d1) {
+  uint64_t low = mph->reciprocal * (f1 + d0 * f2 + d1);
+  return ((__uint128_t) low * mph->size) >> 64;
+}
+
+struct mph_key {
+  size_t num, bucket;
+  uint64_t f1, f2;
+};
+
+static int compare_bucket(const void *a, const void *b) {
+  size_t ba = ((const struct mph_key *) a)->bucket;
+  size_t bb = ((const struct mph_key *) b)->bucket;
+  return (ba > bb) - (ba < bb);
+}
+
+// d0 alternates between up to MPH_D0_RANGE values while d1 runs through
+// all slots, so a bucket of one key always finds the last free slot and
+// keys colliding in f1 are separated by d0 early, whatever the size.
+#define MPH_D0_RANGE 64
+#define MPH_MAX_SEEDS 8
+
+// Place the keys of one bucket, which are keys[0..length), into free
+// slots. taken marks the slots already in use.
+static bool mph_place(struct econf_mph *mph, const struct mph_key *keys,
+                      size_t length, bool *taken) {
+  uint32_t range = mph->size < MPH_D0_RANGE ? mph->size : MPH_D0_RANGE;
+  for (uint64_t tries = 0; tries < (uint64_t) range * mph->size; tries++) {
+    uint32_t d0 = tries % range, d1 = tries / range;
+    size_t i;
+    for (i = 0; i < length; i++) {
+      size_t pos = mph_slot(mph, keys[i].f1, keys[i].f2, d0, d1);
+      if (taken[pos])
+        break;
+      taken[pos] = true;
+      mph->slots[pos] = keys[i].num;
+    }
+    if (i == length) {
+      mph->disp[2 * keys[0].bucket] = d0;
+      mph->disp[2 * keys[0].bucket + 1] = d1;
+      return true;
+    }
+    while (i--)
+      taken[mph_slot(mph, keys[i].f1, keys[i].f2, d0, d1)] = false;
+  }
+  return false;
+}
+
+// Try to build the perfect hash with the seed already set in mph. The
+// buckets are placed largest first, which is when the most slots are free.
+// start holds room for the start and size of n buckets.
+static bool mph_try(struct econf_mph *mph, const econf_file *kf,
+                    struct mph_key *keys, size_t *start, bool *taken) {
+  size_t n = mph->size, k = 0;
+  for (size_t i = 0; i < kf->group_length; i++)
+    for (size_t j = 0; j < kf->groups[i].key_length; j++, k++) {
+      keys[k].num = kf->groups[i].keys[j];
+      mph_hash(mph, kf->file_entry[keys[k].num].hash, &keys[k].bucket,
+               &keys[k].f1, &keys[k].f2);
+    }
+  qsort(keys, n, sizeof(struct mph_key), compare_bucket);
+
+  // The buckets hold only a few keys each, so they are placed by
+  // walking the list of buckets once per size.
+  size_t max = 0, starts = 0;
+  for (size_t i = 0; i < n; starts++) {
+    size_t j = i;
+    while (j < n && keys[j].bucket == keys[i].bucket)
+      j++;
+    start[2 * starts] = i;
+    start[2 * starts + 1] = j - i;
+    if (j - i > max)
+      max = j - i;
+    i = j;
+  }
+
+  memset(taken, 0, n * sizeof(bool));
+  memset(mph->disp, 0, 2 * mph->buckets * sizeof(uint32_t));
+  for (size_t length = max; length > 0; length--)
+    for (size_t s = 0; s < starts; s++)
+      if (start[2 * s + 1] == length &&
+          !mph_place(mph, &keys[start[2 * s]], length, taken))
+        return false;
+  return true;
+}
+
+econf_err index_freeze(econf_file *kf) {
+  for (size_t i = 0; i < kf->group_length; i++) {
+    size_t first, last;
+    econf_err error = index_prefix_range(kf, &kf->groups[i], "", 0,
+                                         &first, &last);
+    if (error)
+      return error;
+  }
+  if (kf->mph.size || !kf->key_table_used ||
+      kf->key_table_used > UINT32_MAX / (MPH_D0_RANGE + 2))
+    return ECONF_SUCCESS;
+
+  struct econf_mph mph = {
+    .reciprocal = UINT64_MAX / kf->key_table_used + 1,
+    .size = kf->key_table_used,
+    .buckets = kf->key_table_used / 4 + 1
+  };
+  struct mph_key *keys = malloc(mph.size * sizeof(struct mph_key));
+  size_t *start = malloc(2 * mph.size * sizeof(size_t));
+  bool *taken = malloc(mph.size * sizeof(bool));
+  mph.disp = malloc(2 * mph.buckets * sizeof(uint32_t));
+  mph.slots = malloc(mph.size * sizeof(size_t));
+  econf_err error = ECONF_NOMEM;
+  if (keys && start && taken && mph.disp && mph.slots) {
+    // Entries with the same 64 bit hash can never be separated; key_table
+    // stays in use then.
+    error = ECONF_SUCCESS;
+    for (int seed = 0; seed < MPH_MAX_SEEDS; seed++) {
+      mph.seed = fmix(seed + 1);
+      if (mph_try(&mph, kf, keys, start, taken)) {
+        kf->mph = mph;
+        mph.disp = NULL;
+        mph.slots = NULL;
+        break;
+      }
+    }
+  }
+  free(keys);
+  free(start);
+  free(taken);
+  free(mph.disp);
+  free(mph.slots);
+  return error;
+}
+
+// The counters may be updated by concurrent readers. Counting is opt-in,
+// by default lookups do not write to the file.
+static econf_err count(const econf_file *kf, uint64_t *counter,
+                       econf_err error) {
+  if (kf->count_lookups)
+    __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+  return error;
+}
+
+econf_err index_find_key(econf_file *kf, const char *group, const char *key,
+                         size_t *num) {
+  return index_find_hash(kf, key_hash(group, key, kf->fold_case), group, key,
+                         num);
+}
+
+econf_err index_find_hash(econf_file *kf, uint64_t hash, const char *group,
+                          const char *key, size_t *num) {
+  if (!kf->key_table_size)
+    return count(kf, &kf->lookup_filtered, ECONF_NOKEY);
+
+  uint64_t mask;
+  if ((*filter_word(kf, hash, &mask) & mask) != mask)
+    return count(kf, &kf->lookup_filtered, ECONF_NOKEY);
+
+  if (kf->mph.size) {
+    size_t bucket;
+    uint64_t f1, f2;
+    count(kf, &kf->lookup_perfect, ECONF_SUCCESS);
+    mph_hash(&kf->mph, hash, &bucket, &f1, &f2);
+    size_t pos = mph_slot(&kf->mph, f1, f2, kf->mph.disp[2 * bucket],
+                          kf->mph.disp[2 * bucket + 1]);
+    struct file_entry *fe = &kf->file_entry[kf->mph.slots[pos]];
+    if (fe->hash == hash && names_equal(fe->key, key, kf->fold_case) &&
+        group_matches(fe->group, group, kf->fold_case)) {
+      *num = kf->mph.slots[pos];
+      return count(kf, &kf->lookup_hits, ECONF_SUCCESS);
+    }
+    return count(kf, &kf->lookup_misses, ECONF_NOKEY);
+  }
+
+  size_t pos = slot(hash, kf->key_table_size);
+  while (kf->key_table[pos]) {
+    struct file_entry *fe = &kf->file_entry[kf->key_table[pos] - 1];
+    if (fe->hash == hash && names_equal(fe->key, key, kf->fold_case) &&
+        group_matches(fe->group, group, kf->fold_case)) {
+      *num = kf->key_table[pos] - 1;
+      return count(kf, &kf->lookup_hits, ECONF_SUCCESS);
+    }
+    pos = (pos + 1) & (kf->key_table_size - 1);
+  }
+  return count(kf, &kf->lookup_misses, ECONF_NOKEY);
+}
+
+// Compare the first length characters of a and b like strncmp(),
+// ignoring ASCII case if fold_case is set
+static int compare_n(const char *a, const char *b, size_t length,
+                     bool fold_case) {
+  for (size_t i = 0; i < length; i++) {
+    int ca = (unsigned char) a[i], cb = (unsigned char) b[i];
+    if (fold_case) {
+      if (ca >= 'A' && ca <= 'Z')
+        ca += 'a' - 'A';
+      if (cb >= 'A' && cb <= 'Z')
+        cb += 'a' - 'A';
+    }
+    if (ca != cb)
+      return ca - cb;
+    if (!ca)
+      break;
+  }
+  return 0;
+}
+
+static int compare_sorted(const void *a, const void *b) {
+  return compare_n(((const struct econf_sorted_key *) a)->key,
+                   ((const struct econf_sorted_key *) b)->key, SIZE_MAX, false);
+}
+
+static int compare_sorted_fold(const void *a, const void *b) {
+  return compare_n(((const struct econf_sorted_key *) a)->key,
+                   ((const struct econf_sorted_key *) b)->key, SIZE_MAX, true);
+}
+
+// First position in grp->sorted whose key, compared on the first length
+// characters, is not below prefix (below_or_equal == false) or above it
+static size_t bound(struct econf_group *grp, const char *prefix,
+                    size_t length, bool fold_case, bool below_or_equal) {
+  size_t low = 0, high = grp->key_length;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    int cmp = compare_n(grp->sorted[mid].key, prefix, length, fold_case);
+    if (cmp < 0 || (below_or_equal && cmp == 0))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+econf_err index_prefix_range(econf_file *kf, struct econf_group *grp,
+                             const char *prefix, size_t length,
+                             size_t *first, size_t *last) {
+  if (grp->sorted == NULL && grp->key_length) {
+    grp->sorted = malloc(grp->key_length * sizeof(struct econf_sorted_key));
+    if (grp->sorted == NULL)
+      return ECONF_NOMEM;
+    for (size_t i = 0; i < grp->key_length; i++) {
+      grp->sorted[i].key = kf->file_entry[grp->keys[i]].key;
+      grp->sorted[i].num = grp->keys[i];
+    }
+    qsort(grp->sorted, grp->key_length, sizeof(struct econf_sorted_key),
+          kf->fold_case ? compare_sorted_fold : compare_sorted);
+  }
+
+  *first = bound(grp, prefix, length, kf->fold_case, false);
+  *last = bound(grp, prefix, length, kf->fold_case, true);
+  return ECONF_SUCCESS;
+}
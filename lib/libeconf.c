@@ -27,9 +27,12 @@
 #include "../include/getfilecontents.h"
 #include "../include/helpers.h"
 #include "../include/keyfile.h"
+#include "../include/keyindex.h"
 #include "../include/mergefiles.h"
+#include "../include/sources.h"
 
 #include <dirent.h>
+#include <fnmatch.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -59,6 +62,8 @@ econf_newKeyFile(econf_file **result, char delimiter, char comment)
   for (size_t i = 0; i < KEY_FILE_DEFAULT_LENGTH; i++)
     initialize(key_file, i);
 
+  new_generation(key_file);
+
   *result = key_file;
 
   return ECONF_SUCCESS;
@@ -71,6 +76,13 @@ econf_err econf_newIniFile(econf_file **result) {
 // Process the file of the given file_name and save its contents into key_file
 econf_err econf_readFile(econf_file **key_file, const char *file_name,
 			     const char *delim, const char *comment)
+{
+  return econf_readFileWithFlags(key_file, file_name, delim, comment, 0);
+}
+
+econf_err econf_readFileWithFlags(econf_file **key_file, const char *file_name,
+				  const char *delim, const char *comment,
+				  unsigned int flags)
 {
   econf_err t_err;
 
@@ -92,6 +104,7 @@ econf_err econf_readFile(econf_file **key_file, const char *file_name,
     (*key_file)->comment = comment[0];
   else
     (*key_file)->comment = '#';
+  (*key_file)->fold_case = (flags & ECONF_CASE_INSENSITIVE) != 0;
 
   t_err = read_file(*key_file, absolute_path, delim, comment);
   free (absolute_path);
@@ -102,6 +115,7 @@ econf_err econf_readFile(econf_file **key_file, const char *file_name,
     return t_err;
   }
 
+  new_generation(*key_file);
   return ECONF_SUCCESS;
 }
 
@@ -111,35 +125,47 @@ econf_err econf_mergeFiles(econf_file **merged_file, econf_file *usr_file, econf
   if (merged_file == NULL || usr_file == NULL || etc_file == NULL)
     return ECONF_ERROR;
 
-  *merged_file = calloc(1, sizeof(econf_file));
-  if (*merged_file == NULL)
-    return ECONF_NOMEM;
+  econf_file *key_files[2] = {usr_file, etc_file};
+  econf_err error = merge_files(key_files, 2, NULL, false, merged_file);
+  if (error)
+    *merged_file = NULL;
+  return error;
+}
 
-  (*merged_file)->delimiter = usr_file->delimiter;
-  (*merged_file)->comment = usr_file->comment;
-  struct file_entry *fe =
-      malloc((etc_file->length + usr_file->length) * sizeof(struct file_entry));
-  if (fe == NULL)
-    {
-      free (*merged_file);
-      *merged_file = NULL;
-      return ECONF_NOMEM;
+// Merge src into dst, moving the strings of both instead of copying them
+econf_err econf_mergeFilesInto(econf_file *dst, econf_file *src)
+{
+  if (dst == NULL || src == NULL || dst == src ||
+      dst->fold_case != src->fold_case)
+    return ECONF_ERROR;
+  if (dst->frozen)
+    return ECONF_FROZEN;
+
+  econf_file *key_files[2] = {dst, src}, *merged = NULL;
+  const bool steal[2] = {true, true};
+  econf_err error = merge_files(key_files, 2, steal, dst->fold_case, &merged);
+  econf_freeFile(src);
+
+  if (error) {
+    // Part of the strings may be gone already, leave dst empty
+    for (size_t i = 0; i < dst->length; i++) {
+      struct file_entry *fe = &dst->file_entry[i];
+      refstr_unref(fe->group);
+      refstr_unref(fe->key);
+      refstr_unref(fe->value);
+      fe->group = fe->key = fe->value = NULL;
+      fe->cache_type = CACHE_NONE;
     }
-
-  size_t merge_length = 0;
-
-  if ((etc_file->file_entry == NULL ||
-       !strcmp(etc_file->file_entry->group, KEY_FILE_NULL_VALUE)) &&
-      (usr_file->file_entry == NULL ||
-       strcmp(usr_file->file_entry->group, KEY_FILE_NULL_VALUE))) {
-    merge_length = insert_nogroup(&fe, etc_file);
+    dst->length = 0;
+    new_generation(dst);
+    index_build(dst);
+    return error;
   }
-  merge_length = merge_existing_groups(&fe, usr_file, etc_file, merge_length);
-  merge_length = add_new_groups(&fe, usr_file, etc_file, merge_length);
-  (*merged_file)->length = merge_length;
-  (*merged_file)->alloc_length = merge_length;
 
-  (*merged_file)->file_entry = fe;
+  move_file_contents(dst, merged);
+  // The files dst was read from no longer describe its contents
+  sources_free(dst->sources);
+  dst->sources = NULL;
   return ECONF_SUCCESS;
 }
 
@@ -151,132 +177,50 @@ econf_err econf_readDirs(econf_file **result,
                                    const char *delim,
 				   const char *comment)
 {
-  size_t size = 0;
-  const char *suffix, *default_dirs[3] = {NULL, NULL, NULL};
-  char *distfile, *etcfile, *cp;
-  econf_file **key_files, *key_file;
+  return econf_readDirsWithFlags(result, dist_conf_dir, etc_conf_dir,
+				 project_name, config_suffix, delim, comment, 0);
+}
+
+econf_err econf_readDirsWithFlags(econf_file **result,
+				  const char *dist_conf_dir,
+				  const char *etc_conf_dir,
+				  const char *project_name,
+				  const char *config_suffix,
+				  const char *delim,
+				  const char *comment,
+				  unsigned int flags)
+{
+  struct econf_sources *sources;
   econf_err error;
+  bool changed;
+  bool refreshable = (flags & ECONF_REFRESHABLE) != 0;
 
   /* config_suffix must be provided and should not be "" */
   if (config_suffix == NULL || strlen (config_suffix) == 0 ||
-      project_name == NULL || strlen (project_name) == 0 || delim == NULL)
+      project_name == NULL || strlen (project_name) == 0 || delim == NULL ||
+      (flags & ~ECONF_REFRESHABLE))
     return ECONF_ERROR;
 
-  // Prepend a . to the config suffix if not provided
-  if (config_suffix[0] == '.')
-    suffix = config_suffix;
-  else
-    {
-      cp = alloca (strlen(config_suffix) + 2);
-      cp[0] = '.';
-      strcpy(cp+1, config_suffix);
-      suffix = cp;
-    }
-
-  /* create file names for etc and distribution config */
-  if (dist_conf_dir != NULL)
+  if ((error = sources_new(&sources, dist_conf_dir, etc_conf_dir,
+			   project_name, config_suffix, delim, comment)))
+    return error;
+  if ((error = sources_scan(sources, &changed)) ||
+      (error = sources_merge(sources, result, !refreshable)))
     {
-      distfile = alloca(strlen (dist_conf_dir) + strlen (project_name) +
-			strlen (suffix) + 2);
-
-      cp = stpcpy (distfile, dist_conf_dir);
-      *cp++ = '/';
-      cp = stpcpy (cp, project_name);
-      stpcpy (cp, suffix);
+      sources_free(sources);
+      if (error == ECONF_NOFILE)
+	*result = NULL;
+      return error;
     }
-  else
-    distfile = NULL;
 
-  if (etc_conf_dir != NULL)
-    {
-      etcfile = alloca(strlen (etc_conf_dir) + strlen (project_name) +
-		       strlen (suffix) + 2);
-
-      cp = stpcpy (etcfile, etc_conf_dir);
-      *cp++ = '/';
-      cp = stpcpy (cp, project_name);
-      stpcpy (cp, suffix);
-    }
+  /* The parsed files are only kept for econf_refresh(), otherwise their
+     strings have been moved into the result.  */
+  if (refreshable)
+    (*result)->sources = sources;
   else
-    etcfile = NULL;
-
-  if (etcfile)
-    {
-      error = econf_readFile(&key_file, etcfile, delim, comment);
-      if (error && error != ECONF_NOFILE)
-	return error;
-    }
-
-  if (etcfile && !error) {
-    /* /etc/<project_name>.<suffix> does exist, ignore /usr */
-    default_dirs[0] = etc_conf_dir;
-    size = 1;
-  } else {
-    /* /etc/<project_name>.<suffix> does not exist, so read /usr/etc
-       and merge all *.d files. */
-    if (distfile)
-      {
-	error = econf_readFile(&key_file, distfile, delim, comment);
-	if (error && error != ECONF_NOFILE)
-	  return error;
-      }
-
-    if (distfile && !error) /* /usr/etc/<project_name>.<suffix> does exist */
-      size = 1;
-
-    default_dirs[0] = dist_conf_dir;
-    default_dirs[1] = etc_conf_dir;
-  }
+    sources_free(sources);
 
-  /* XXX Re-add get_default_dirs in a reworked version, which
-     adds additional directories to look at, e.g. XDG or home directory */
-
-  /* create space to store the econf_files for merging */
-  key_files = calloc((++size), sizeof(econf_file*));
-  if (key_files == NULL)
-    return ECONF_NOMEM;
-
-  if (size == 2)
-    {
-      key_file->on_merge_delete = 1;
-      key_files[0] = key_file;
-    }
-
-  int i = 0;
-  while (default_dirs[i]) {
-    /*
-      Indicate which directories to look for. The order is:
-       "default_dirs/project_name.suffix.d/"
-
-       XXX make this configureable:
-       "default_dirs/project_name/conf.d/"
-       "default_dirs/project_name.d/"
-       "default_dirs/project_name/"
-    */
-    const char *conf_dirs[] = {  NULL, /* "/conf.d/", ".d/", "/", */ NULL};
-    char *project_path = combine_strings(default_dirs[i], project_name, '/');
-    char *suffix_d = malloc (strlen(suffix) + 4); /* + strlen(".d/") */
-    /* XXX ENOMEM/NULL pointer check */
-    cp = stpcpy(suffix_d, suffix);
-    stpcpy(cp, ".d/");
-    conf_dirs[0] = suffix_d;
-    key_files = traverse_conf_dirs(key_files, conf_dirs, &size, project_path,
-                                   suffix, delim, comment);
-    /* XXX ENOMEM/NULL pointer check */
-    free(suffix_d);
-    free(project_path);
-    i++;
-  }
-  key_files[size - 1] = NULL;
-
-  // Merge the list of acquired key_files into merged_file
-  error = merge_econf_files(key_files, result);
-  free(key_files);
-
-  if (size == 1)
-    return ECONF_NOFILE;
-  else
-    return error;
+  return ECONF_SUCCESS;
 }
 
 // Write content of a econf_file struct to specified location
@@ -322,95 +266,200 @@ econf_err econf_writeFile(econf_file *key_file, const char *save_to_dir,
 }
 
 /* GETTER FUNCTIONS */
-// TODO: Currently only works with a sorted econf_file. If a new
-// key with an existing group is appended at the end the group
-// will show twice. So the key file either needs to be sorted
-// upon entering a new key or the function must ensure only
-// unique values are returned.
 econf_err
 econf_getGroups(econf_file *kf, size_t *length, char ***groups)
 {
   if (!kf || groups == NULL)
     return ECONF_ERROR;
 
+  // The group directory lists every group once, in order of appearance
   size_t tmp = 0;
-  bool *uniques = calloc(kf->length,sizeof(bool));
-  if (uniques == NULL)
-    return ECONF_NOMEM;
-
-  for (size_t i = 0; i < kf->length; i++) {
-    if ((!i || strcmp(kf->file_entry[i].group, kf->file_entry[i - 1].group)) &&
-        strcmp(kf->file_entry[i].group, KEY_FILE_NULL_VALUE)) {
-      uniques[i] = 1;
+  for (size_t i = 0; i < kf->group_length; i++)
+    if (strcmp(kf->groups[i].name, KEY_FILE_NULL_VALUE))
       tmp++;
-    }
-  }
-  if (!tmp) {
-    free(uniques);
+  if (!tmp)
     return ECONF_ERROR;
-  }
+
   *groups = calloc(tmp + 1, sizeof(char*));
   if (*groups == NULL)
     return ECONF_NOMEM;
 
   tmp = 0;
-  for (size_t i = 0; i < kf->length; i++)
-    if (uniques[i])
-      (*groups)[tmp++] = strdup(kf->file_entry[i].group);
+  for (size_t i = 0; i < kf->group_length; i++) {
+    if (!strcmp(kf->groups[i].name, KEY_FILE_NULL_VALUE))
+      continue;
+    if (((*groups)[tmp++] = strdup(kf->groups[i].name)) == NULL) {
+      econf_freeArray(*groups);
+      *groups = NULL;
+      return ECONF_NOMEM;
+    }
+  }
 
   if (length != NULL)
     *length = tmp;
 
-  free(uniques);
   return ECONF_SUCCESS;
 }
 
-// TODO: Same issue as with getGroups()
 econf_err
 econf_getKeys(econf_file *kf, const char *grp, size_t *length, char ***keys)
 {
-  if (!kf)
+  if (!kf || keys == NULL)
     return ECONF_ERROR;
 
-  size_t tmp = 0;
-  char *group = ((!grp || !*grp) ? strdup(KEY_FILE_NULL_VALUE) :
-                 addbrackets(grp));
-  if (group == NULL)
+  struct econf_group *group = index_find_group(kf, grp);
+  if (group == NULL || !group->key_length)
+    return ECONF_NOKEY;
+
+  *keys = calloc(group->key_length + 1, sizeof(char*));
+  if (*keys == NULL)
     return ECONF_NOMEM;
 
-  bool *uniques = calloc(kf->length, sizeof(bool));
-  if (uniques == NULL)
-    {
-      free(group);
+  for (size_t i = 0; i < group->key_length; i++)
+    if (((*keys)[i] = strdup(kf->file_entry[group->keys[i]].key)) == NULL) {
+      econf_freeArray(*keys);
+      *keys = NULL;
       return ECONF_NOMEM;
     }
-  for (size_t i = 0; i < kf->length; i++) {
-    if (!strcmp(kf->file_entry[i].group, group) &&
-        (!i || strcmp(kf->file_entry[i].key, kf->file_entry[i - 1].key))) {
-      uniques[i] = 1;
-      tmp++;
-    }
+
+  if (length != NULL)
+    *length = group->key_length;
+
+  return ECONF_SUCCESS;
+}
+
+static int
+compare_num(const void *a, const void *b)
+{
+  size_t x = *(const size_t *) a, y = *(const size_t *) b;
+  return x < y ? -1 : x > y;
+}
+
+/* Return the keys of group starting with the first length characters of
+   pattern which also match pattern, if is_glob is set. */
+static econf_err
+get_keys_matching(econf_file *kf, const char *grp, const char *pattern,
+		  size_t length, bool is_glob, size_t *key_length, char ***keys)
+{
+  struct econf_group *group = index_find_group(kf, grp);
+  size_t first, last, found = 0, *nums;
+  econf_err error;
+
+  if (group == NULL)
+    return ECONF_NOKEY;
+  if ((error = index_prefix_range(kf, group, pattern, length, &first, &last)))
+    return error;
+  if (first == last)
+    return ECONF_NOKEY;
+
+  nums = malloc((last - first) * sizeof(size_t));
+  if (nums == NULL)
+    return ECONF_NOMEM;
+  for (size_t i = first; i < last; i++)
+    if (!is_glob || !fnmatch(pattern, group->sorted[i].key,
+			     kf->fold_case ? FNM_CASEFOLD : 0))
+      nums[found++] = group->sorted[i].num;
+  if (!found) {
+    free(nums);
+    return ECONF_NOKEY;
   }
-  free(group);
-  if (!tmp)
-    {
-      free (uniques);
-      return ECONF_NOKEY;
-    }
-  *keys = calloc(tmp + 1, sizeof(char*));
+
+  /* Report the keys in order of their first appearance like econf_getKeys */
+  qsort(nums, found, sizeof(size_t), compare_num);
+  *keys = calloc(found + 1, sizeof(char*));
   if (*keys == NULL) {
-    free (uniques);
+    free(nums);
     return ECONF_NOMEM;
   }
+  for (size_t i = 0; i < found; i++)
+    if (((*keys)[i] = strdup(kf->file_entry[nums[i]].key)) == NULL) {
+      econf_freeArray(*keys);
+      *keys = NULL;
+      free(nums);
+      return ECONF_NOMEM;
+    }
+  free(nums);
 
-  for (size_t i = 0, j = 0; i < kf->length; i++)
-    if (uniques[i])
-      (*keys)[j++] = strdup(kf->file_entry[i].key);
+  if (key_length != NULL)
+    *key_length = found;
 
-  if (length != NULL)
-    *length = tmp;
+  return ECONF_SUCCESS;
+}
+
+econf_err
+econf_getKeysPrefix(econf_file *kf, const char *group, const char *prefix,
+		    size_t *length, char ***keys)
+{
+  if (!kf || !prefix || keys == NULL)
+    return ECONF_ERROR;
+
+  return get_keys_matching(kf, group, prefix, strlen(prefix), false,
+			   length, keys);
+}
+
+econf_err
+econf_getKeysGlob(econf_file *kf, const char *group, const char *pattern,
+		  size_t *length, char ***keys)
+{
+  if (!kf || !pattern || keys == NULL)
+    return ECONF_ERROR;
+
+  /* Only keys starting with the part before the first wildcard can match */
+  return get_keys_matching(kf, group, pattern, strcspn(pattern, "*?[\\"),
+			   true, length, keys);
+}
 
-  free(uniques);
+econf_err
+econf_iterInit(econf_file *kf, enum econf_iter_order order, econf_iter *iter)
+{
+  if (!kf || iter == NULL ||
+      (order != ECONF_ITER_FILE_ORDER && order != ECONF_ITER_GROUPED))
+    return ECONF_ERROR;
+
+  memset(iter, 0, sizeof(*iter));
+  iter->kf = kf;
+  iter->generation = kf->generation;
+  iter->order = order;
+  return ECONF_SUCCESS;
+}
+
+econf_err
+econf_iterNext(econf_iter *iter)
+{
+  if (iter == NULL || !iter->kf)
+    return ECONF_ERROR;
+
+  econf_file *kf = iter->kf;
+  if (iter->generation != kf->generation)
+    return ECONF_INVALID_HANDLE;
+
+  struct file_entry *fe = NULL;
+  if (iter->order == ECONF_ITER_GROUPED)
+    {
+      while (iter->group_pos < kf->group_length &&
+	     iter->pos >= kf->groups[iter->group_pos].key_length)
+	{
+	  iter->group_pos++;
+	  iter->pos = 0;
+	}
+      if (iter->group_pos < kf->group_length)
+	fe = &kf->file_entry[kf->groups[iter->group_pos].keys[iter->pos++]];
+    }
+  else
+    {
+      /* Later duplicates of a key are never returned by the getters */
+      while (iter->pos < kf->length && !kf->file_entry[iter->pos].indexed)
+	iter->pos++;
+      if (iter->pos < kf->length)
+	fe = &kf->file_entry[iter->pos++];
+    }
+  if (fe == NULL)
+    return ECONF_NOKEY;
+
+  iter->group = strcmp(fe->group, KEY_FILE_NULL_VALUE) ? fe->group : NULL;
+  iter->key = fe->key;
+  iter->value = fe->value;
+  iter->line_number = fe->line_number;
   return ECONF_SUCCESS;
 }
 
@@ -423,7 +472,7 @@ econf_err econf_get ## FCT_TYPE ## Value(econf_file *kf, const char *group, \
     return ECONF_ERROR; \
 \
   size_t num; \
-  econf_err error = find_key(*kf, group, key, &num);	\
+  econf_err error = find_key(kf, group, key, &num);	\
   if (error) \
     return error; \
   return get ## FCT_TYPE ## ValueNum(*kf, num, result);	\
@@ -438,6 +487,409 @@ econf_getValue(Double, double)
 econf_getValue(String, char *)
 econf_getValue(Bool, bool)
 
+econf_err
+econf_getStringValueRefLen(econf_file *kf, const char *group, const char *key,
+			   const char **result, size_t *length)
+{
+  if (!kf || result == NULL)
+    return ECONF_ERROR;
+
+  size_t num;
+  econf_err error = find_key(kf, group, key, &num);
+  if (error)
+    return error;
+
+  *result = kf->file_entry[num].value;
+  if (length != NULL)
+    *length = *result ? strlen(*result) : 0;
+  return ECONF_SUCCESS;
+}
+
+econf_err
+econf_getStringValueRef(econf_file *kf, const char *group, const char *key,
+			const char **result)
+{
+  return econf_getStringValueRefLen(kf, group, key, result, NULL);
+}
+
+econf_err
+econf_getValueSource(econf_file *kf, const char *group, const char *key,
+		     const char **path, uint64_t *line_number)
+{
+  if (!kf || path == NULL)
+    return ECONF_ERROR;
+
+  size_t num;
+  econf_err error = find_key(kf, group, key, &num);
+  if (error)
+    return error;
+
+  const struct file_entry *fe = &kf->file_entry[num];
+  bool from_file = fe->source != KEY_FILE_NO_SOURCE;
+  *path = from_file ? kf->paths[fe->source] : NULL;
+  if (line_number != NULL)
+    *line_number = from_file ? fe->line_number : 0;
+  return ECONF_SUCCESS;
+}
+
+econf_err
+econf_countLookups(econf_file *kf, bool enable)
+{
+  if (!kf)
+    return ECONF_ERROR;
+  if (kf->frozen)
+    return ECONF_FROZEN;
+
+  kf->count_lookups = enable;
+  return ECONF_SUCCESS;
+}
+
+econf_err
+econf_getLookupStats(econf_file *kf, econf_lookup_stats *stats)
+{
+  if (!kf || !stats)
+    return ECONF_ERROR;
+
+  stats->hits = __atomic_load_n(&kf->lookup_hits, __ATOMIC_RELAXED);
+  stats->filtered = __atomic_load_n(&kf->lookup_filtered, __ATOMIC_RELAXED);
+  stats->misses = __atomic_load_n(&kf->lookup_misses, __ATOMIC_RELAXED);
+  stats->perfect = __atomic_load_n(&kf->lookup_perfect, __ATOMIC_RELAXED);
+  return ECONF_SUCCESS;
+}
+
+econf_err
+econf_resolveKey(econf_file *kf, const char *group, const char *key,
+		 econf_keyhandle *handle)
+{
+  if (!kf || !handle)
+    return ECONF_ERROR;
+
+  size_t num;
+  econf_err error = find_key(kf, group, key, &num);
+  if (error)
+    return error;
+
+  handle->num = num;
+  handle->generation = kf->generation;
+  return ECONF_SUCCESS;
+}
+
+/* The econf_get*ValueH functions only check that the handle still belongs
+   to the current generation of kf and access the entry directly. */
+#define econf_getValueH(FCT_TYPE, TYPE)			      \
+econf_err econf_get ## FCT_TYPE ## ValueH(econf_file *kf, \
+			     econf_keyhandle handle, TYPE *result) {	\
+  if (!kf) \
+    return ECONF_ERROR; \
+  if (handle.generation != kf->generation || handle.num >= kf->length) \
+    return ECONF_INVALID_HANDLE; \
+  return get ## FCT_TYPE ## ValueNum(*kf, handle.num, result);	\
+}
+
+econf_getValueH(Int, int32_t)
+econf_getValueH(Int64, int64_t)
+econf_getValueH(UInt, uint32_t)
+econf_getValueH(UInt64, uint64_t)
+econf_getValueH(Float, float)
+econf_getValueH(Double, double)
+econf_getValueH(String, char *)
+econf_getValueH(Bool, bool)
+
+/* The econf_get*ValueK functions skip hashing the names unless kf
+   folds case, then the precomputed hash does not apply. */
+#define econf_getValueK(FCT_TYPE, TYPE)			      \
+econf_err econf_get ## FCT_TYPE ## ValueK(econf_file *kf, econf_key key, \
+					  TYPE *result) {		\
+  if (!kf || !key.key || !*key.key) \
+    return ECONF_ERROR; \
+  uint64_t hash = kf->fold_case ? key_hash(key.group, key.key, true) : key.hash; \
+  size_t num; \
+  econf_err error = index_find_hash(kf, hash, key.group, key.key, &num); \
+  if (error) \
+    return error; \
+  return get ## FCT_TYPE ## ValueNum(*kf, num, result);	\
+}
+
+econf_getValueK(Int, int32_t)
+econf_getValueK(Int64, int64_t)
+econf_getValueK(UInt, uint32_t)
+econf_getValueK(UInt64, uint64_t)
+econf_getValueK(Float, float)
+econf_getValueK(Double, double)
+econf_getValueK(String, char *)
+econf_getValueK(Bool, bool)
+
+/* Read the value of one query from the entry num */
+static econf_err
+get_query_value(econf_file *kf, size_t num, const econf_query *q)
+{
+  switch (q->type) {
+  case ECONF_TYPE_INT:
+    return getIntValueNum(*kf, num, q->result);
+  case ECONF_TYPE_INT64:
+    return getInt64ValueNum(*kf, num, q->result);
+  case ECONF_TYPE_UINT:
+    return getUIntValueNum(*kf, num, q->result);
+  case ECONF_TYPE_UINT64:
+    return getUInt64ValueNum(*kf, num, q->result);
+  case ECONF_TYPE_FLOAT:
+    return getFloatValueNum(*kf, num, q->result);
+  case ECONF_TYPE_DOUBLE:
+    return getDoubleValueNum(*kf, num, q->result);
+  case ECONF_TYPE_STRING:
+    return getStringValueNum(*kf, num, q->result);
+  case ECONF_TYPE_BOOL:
+    return getBoolValueNum(*kf, num, q->result);
+  }
+  return ECONF_ERROR;
+}
+
+/* Store the default value def of the given type into result */
+static econf_err
+set_default(econf_type type, void *result, const void *def)
+{
+  switch (type) {
+  case ECONF_TYPE_INT:
+    *(int32_t *) result = *(const int32_t *) def;
+    break;
+  case ECONF_TYPE_INT64:
+    *(int64_t *) result = *(const int64_t *) def;
+    break;
+  case ECONF_TYPE_UINT:
+    *(uint32_t *) result = *(const uint32_t *) def;
+    break;
+  case ECONF_TYPE_UINT64:
+    *(uint64_t *) result = *(const uint64_t *) def;
+    break;
+  case ECONF_TYPE_FLOAT:
+    *(float *) result = *(const float *) def;
+    break;
+  case ECONF_TYPE_DOUBLE:
+    *(double *) result = *(const double *) def;
+    break;
+  case ECONF_TYPE_STRING:
+    if ((*(char **) result = strdup(def)) == NULL)
+      return ECONF_NOMEM;
+    break;
+  case ECONF_TYPE_BOOL:
+    *(bool *) result = *(const bool *) def;
+    break;
+  default:
+    return ECONF_ERROR;
+  }
+  return ECONF_NOKEY;
+}
+
+/* Answer one query, returning its status */
+static econf_err
+get_query(econf_file *kf, const econf_query *q)
+{
+  size_t num;
+  econf_err error;
+
+  if (!q->result)
+    return ECONF_ERROR;
+  if ((error = find_key(kf, q->group, q->key, &num)) == ECONF_SUCCESS)
+    return get_query_value(kf, num, q);
+  if (error == ECONF_NOKEY && q->def)
+    return set_default(q->type, q->result, q->def);
+  return error;
+}
+
+/* Every query is a single lookup in the key index, so reading n values
+   from a file with N entries costs O(N+n) instead of O(N*n). */
+econf_err
+econf_getBatch(econf_file *kf, const econf_query *q, size_t n)
+{
+  if (!kf || (!q && n > 0))
+    return ECONF_ERROR;
+
+  econf_err ret = ECONF_SUCCESS;
+  for (size_t i = 0; i < n; i++) {
+    econf_err error = get_query(kf, &q[i]);
+
+    if (q[i].status)
+      *q[i].status = error;
+    if (ret == ECONF_SUCCESS && error != ECONF_SUCCESS &&
+	!(error == ECONF_NOKEY && q[i].def))
+      ret = error;
+  }
+  return ret;
+}
+
+econf_err
+econf_bind(econf_file *kf, const econf_field *schema, size_t n, void *dest,
+	   econf_err *status)
+{
+  if (!kf || !dest || (!schema && n > 0))
+    return ECONF_ERROR;
+
+  econf_err ret = ECONF_SUCCESS;
+  for (size_t i = 0; i < n; i++) {
+    const econf_query q = {schema[i].group, schema[i].key, schema[i].type,
+			   (char *) dest + schema[i].offset, schema[i].def,
+			   NULL};
+    econf_err error = get_query(kf, &q);
+
+    if (status)
+      status[i] = error;
+    if (ret == ECONF_SUCCESS && error != ECONF_SUCCESS &&
+	!(error == ECONF_NOKEY && schema[i].def))
+      ret = error;
+  }
+  return ret;
+}
+
+/* State of econf_readDirsInto() */
+struct bind_files {
+  const econf_field *schema;
+  size_t n;
+  void *dest;
+  const char *delim;
+  const char *comment;
+  uint64_t *hash; /* key_hash() of every field */
+  size_t *table; /* Open addressing table of field numbers + 1 by hash */
+  int table_bits;
+  bool *found; /* field has been found in the current file */
+  bool *merged; /* field has been set by an earlier file */
+  char **value; /* value of the field in the current file */
+  econf_err *status;
+};
+
+static size_t
+bind_slot(const struct bind_files *bf, uint64_t hash)
+{
+  return (hash * 0x9e3779b97f4a7c15ULL) >> (64 - bf->table_bits);
+}
+
+/* Remember the value of every field matching group and key. Duplicates
+   follow merge_files(): the last one overrides a field set by an earlier
+   file, otherwise the first one counts, like for the getters. */
+static econf_err
+bind_entry(void *arg, const char *group, const char *key, const char *value,
+	   uint64_t line_number __attribute__((unused)))
+{
+  struct bind_files *bf = arg;
+  uint64_t hash = key_hash(group, key, false);
+  size_t mask = ((size_t) 1 << bf->table_bits) - 1;
+
+  for (size_t pos = bind_slot(bf, hash); bf->table[pos];
+       pos = (pos + 1) & mask) {
+    size_t i = bf->table[pos] - 1;
+    if ((bf->found[i] && !bf->merged[i]) || bf->hash[i] != hash ||
+	strcmp(bf->schema[i].key, key) ||
+	!group_matches(group ? group : KEY_FILE_NULL_VALUE, bf->schema[i].group,
+		       false))
+      continue;
+    free(bf->value[i]);
+    bf->value[i] = NULL;
+    if (value && (bf->value[i] = strdup(value)) == NULL)
+      return ECONF_NOMEM;
+    bf->found[i] = true;
+  }
+  return ECONF_SUCCESS;
+}
+
+/* Parse one file and, if it is valid, store the values found in it */
+static econf_err
+bind_conf_file(const char *path, bool main_file __attribute__((unused)),
+	       void *arg)
+{
+  struct bind_files *bf = arg;
+  econf_err error = parse_file(path, bf->delim, bf->comment, bind_entry, bf);
+
+  for (size_t i = 0; i < bf->n; i++) {
+    if (!error && bf->found[i]) {
+      void *result = (char *) bf->dest + bf->schema[i].offset;
+
+      if (bf->schema[i].type == ECONF_TYPE_STRING) {
+	char *str;
+	if ((bf->status[i] = parseValue(ECONF_TYPE_STRING, bf->value[i], &str)) == ECONF_SUCCESS) {
+	  free(*(char **) result);
+	  *(char **) result = str;
+	}
+      } else
+	bf->status[i] = parseValue(bf->schema[i].type, bf->value[i], result);
+      bf->merged[i] = true;
+    }
+    free(bf->value[i]);
+    bf->value[i] = NULL;
+    bf->found[i] = false;
+  }
+  return error;
+}
+
+econf_err
+econf_readDirsInto(const econf_field *schema, size_t n, void *dest,
+		   econf_err *status, const char *dist_conf_dir,
+		   const char *etc_conf_dir, const char *project_name,
+		   const char *config_suffix, const char *delim,
+		   const char *comment)
+{
+  struct bind_files bf = {schema, n, dest, delim, comment,
+			  NULL, NULL, 1, NULL, NULL, NULL, NULL};
+  econf_err error = ECONF_SUCCESS;
+
+  /* config_suffix must be provided and should not be "" */
+  if (config_suffix == NULL || strlen (config_suffix) == 0 ||
+      project_name == NULL || strlen (project_name) == 0 || delim == NULL ||
+      !dest || (!schema && n > 0))
+    return ECONF_ERROR;
+  for (size_t i = 0; i < n; i++)
+    if (!schema[i].key)
+      return ECONF_ERROR;
+
+  while (((size_t) 1 << bf.table_bits) < 2 * n)
+    bf.table_bits++;
+  bf.hash = malloc(n * sizeof(uint64_t));
+  bf.table = calloc((size_t) 1 << bf.table_bits, sizeof(size_t));
+  bf.found = calloc(n, sizeof(bool));
+  bf.merged = calloc(n, sizeof(bool));
+  bf.value = calloc(n, sizeof(char *));
+  bf.status = calloc(n, sizeof(econf_err));
+  if (!bf.table ||
+      (n && (!bf.hash || !bf.found || !bf.merged || !bf.value || !bf.status)))
+    error = ECONF_NOMEM;
+
+  for (size_t i = 0; i < n && !error; i++) {
+    void *result = (char *) dest + schema[i].offset;
+
+    bf.hash[i] = key_hash(schema[i].group, schema[i].key, false);
+    size_t pos = bind_slot(&bf, bf.hash[i]);
+    while (bf.table[pos])
+      pos = (pos + 1) & (((size_t) 1 << bf.table_bits) - 1);
+    bf.table[pos] = i + 1;
+    if (schema[i].def)
+      bf.status[i] = set_default(schema[i].type, result, schema[i].def);
+    else {
+      bf.status[i] = ECONF_NOKEY;
+      if (schema[i].type == ECONF_TYPE_STRING)
+	*(char **) result = NULL;
+    }
+    if (bf.status[i] != ECONF_NOKEY)
+      error = bf.status[i];
+  }
+
+  if (!error)
+    error = foreach_conf_file(dist_conf_dir, etc_conf_dir, project_name,
+			      config_suffix, bind_conf_file, &bf);
+
+  for (size_t i = 0; i < n && !error; i++)
+    if (bf.status[i] != ECONF_SUCCESS &&
+	!(bf.status[i] == ECONF_NOKEY && schema[i].def))
+      error = bf.status[i];
+
+  if (status && bf.status)
+    memcpy(status, bf.status, n * sizeof(econf_err));
+  free(bf.hash);
+  free(bf.table);
+  free(bf.found);
+  free(bf.merged);
+  free(bf.value);
+  free(bf.status);
+  return error;
+}
+
 /* SETTER FUNCTIONS */
 /* The econf_set*Value functions are identical except for set
    value type, so let's create them via a macro. */
@@ -458,6 +910,96 @@ libeconf_setValue(Double, double, &value)
 libeconf_setValue(String, const char *, value)
 libeconf_setValue(Bool, const char *, value)
 
+/* Size of the strings of fe, the group counted only if it differs from
+   the one of the previous entry prev. */
+static size_t
+entry_strings_size(const struct file_entry *fe, const struct file_entry *prev)
+{
+  size_t size = 0;
+  if (fe->group && !(prev && prev->group && strcmp(prev->group, fe->group) == 0))
+    size += strlen(fe->group) + 1;
+  if (fe->key)
+    size += strlen(fe->key) + 1;
+  if (fe->value)
+    size += strlen(fe->value) + 1;
+  return size;
+}
+
+static char *
+copy_string(char **dest, const char *src, char *pos)
+{
+  if (!src)
+    return pos;
+  *dest = pos;
+  return stpcpy(pos, src) + 1;
+}
+
+econf_err
+econf_freeze(econf_file *kf)
+{
+  if (!kf)
+    return ECONF_ERROR;
+  if (kf->frozen)
+    return ECONF_SUCCESS;
+
+  /* Copy the entries and their strings into one block first, so that
+     kf is unchanged if anything fails. */
+  size_t size = kf->length * sizeof(struct file_entry);
+  for (size_t i = 0; i < kf->length; i++)
+    size += entry_strings_size(&kf->file_entry[i],
+			       i ? &kf->file_entry[i - 1] : NULL);
+  struct file_entry *fe = malloc(size ? size : 1);
+  if (fe == NULL)
+    return ECONF_NOMEM;
+  char *pos = (char *) (fe + kf->length);
+  for (size_t i = 0; i < kf->length; i++)
+    {
+      const struct file_entry *old = &kf->file_entry[i];
+      fe[i] = *old;
+      fe[i].group = fe[i].key = fe[i].value = NULL;
+      if (i && old->group && fe[i - 1].group &&
+	  strcmp(fe[i - 1].group, old->group) == 0)
+	fe[i].group = fe[i - 1].group;
+      else
+	pos = copy_string(&fe[i].group, old->group, pos);
+      pos = copy_string(&fe[i].key, old->key, pos);
+      pos = copy_string(&fe[i].value, old->value, pos);
+    }
+
+  econf_err error = index_freeze(kf);
+  if (error)
+    {
+      free(fe);
+      return error;
+    }
+
+  for (size_t i = 0; i < kf->alloc_length; i++)
+    {
+      refstr_unref(kf->file_entry[i].group);
+      refstr_unref(kf->file_entry[i].key);
+      refstr_unref(kf->file_entry[i].value);
+    }
+  free(kf->file_entry);
+  kf->file_entry = fe;
+  kf->alloc_length = kf->length;
+  /* A frozen file can't be refreshed, the parsed files are not needed
+     any more. */
+  sources_free(kf->sources);
+  kf->sources = NULL;
+
+  /* The index refers to entries by number, only the names borrowed from
+     them have to be updated. */
+  for (size_t i = 0; i < kf->group_length; i++)
+    {
+      struct econf_group *grp = &kf->groups[i];
+      grp->name = fe[grp->keys[0]].group;
+      for (size_t j = 0; j < grp->key_length; j++)
+	grp->sorted[j].key = fe[grp->sorted[j].num].key;
+    }
+  kf->frozen = true;
+  return ECONF_SUCCESS;
+}
+
 /* --- DESTROY FUNCTIONS --- */
 
 void econf_freeArray(char** array) {
@@ -473,19 +1015,21 @@ void econf_freeFile(econf_file *key_file) {
   if (!key_file)
     return;
 
-  for (size_t i = 0; i < key_file->alloc_length; i++) {
-    if (key_file->file_entry[i].group)
-      free(key_file->file_entry[i].group);
-    if (key_file->file_entry[i].key)
-      free(key_file->file_entry[i].key);
-    if (key_file->file_entry[i].value)
-      free(key_file->file_entry[i].value);
+  /* The strings of a frozen file are part of the file_entry block */
+  for (size_t i = 0; !key_file->frozen && i < key_file->alloc_length; i++) {
+    refstr_unref(key_file->file_entry[i].group);
+    refstr_unref(key_file->file_entry[i].key);
+    refstr_unref(key_file->file_entry[i].value);
   }
 
   if (key_file->file_entry)
     free(key_file->file_entry);
-  if (key_file->path)
-    free(key_file->path);
+  refstr_unref(key_file->path);
+  for (size_t i = 0; i < key_file->path_length; i++)
+    refstr_unref(key_file->paths[i]);
+  free(key_file->paths);
+  index_free(key_file);
+  sources_free(key_file->sources);
 
   free(key_file);
 }
@@ -24,6 +24,7 @@
 #include "libeconf.h"
 #include "../include/defines.h"
 #include "../include/helpers.h"
+#include "../include/keyindex.h"
 #include "../include/mergefiles.h"
 
 #include <dirent.h>
@@ -31,79 +32,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Insert the content of "etc_file.file_entry" into "fe" if there is no
-// group specified
-size_t insert_nogroup(struct file_entry **fe, econf_file *ef) {
-  size_t etc_start = 0;
-  while (etc_start < ef->length &&
-         !strcmp(ef->file_entry[etc_start].group, KEY_FILE_NULL_VALUE)) {
-    (*fe)[etc_start] = cpy_file_entry(ef->file_entry[etc_start]);
-    etc_start++;
-  }
-  return etc_start;
-}
-
-// Merge contents from existing usr_file groups
-// uf: usr_file, ef: etc_file
-size_t merge_existing_groups(struct file_entry **fe, econf_file *uf, econf_file *ef,
-                             const size_t etc_start) {
-  char new_key;
-  size_t merge_length = etc_start, tmp = etc_start, added_keys = etc_start;
-  for (size_t i = 0; i <= uf->length; i++) {
-    // Check if the group has changed in the last iteration
-    if (i == uf->length ||
-        (i && strcmp(uf->file_entry[i].group, uf->file_entry[i - 1].group))) {
-      for (size_t j = etc_start; j < ef->length; j++) {
-        // Check for matching groups
-        if (!strcmp(uf->file_entry[i - 1].group, ef->file_entry[j].group)) {
-          new_key = 1;
-          for (size_t k = merge_length; k < i + tmp; k++) {
-            // If an existing key is found in ef take the value from ef
-            if (!strcmp((*fe)[k].key, ef->file_entry[j].key)) {
-              free((*fe)[k].value);
-              (*fe)[k].value = strdup(ef->file_entry[j].value);
-              new_key = 0;
-              break;
-            }
-          }
-          // If a new key is found for an existing group append it to the group
-          if (new_key)
-            (*fe)[i + added_keys++] = cpy_file_entry(ef->file_entry[j]);
-        }
-      }
-      merge_length = i + added_keys;
-      // Temporary value to reduce amount of iterations in inner for loop
-      tmp = added_keys;
-    }
-    if (i != uf->length)
-      (*fe)[i + added_keys] = cpy_file_entry(uf->file_entry[i]);
-  }
-  return merge_length;
-}
-
-// Add entries from etc_file exclusive groups
-size_t add_new_groups(struct file_entry **fe, econf_file *uf, econf_file *ef,
-                      const size_t merge_length) {
-  size_t added_keys = merge_length;
-  char new_key;
-  for (size_t i = 0; i < ef->length; i++) {
-    if (!strcmp(ef->file_entry[i].group, KEY_FILE_NULL_VALUE))
-      continue;
-    new_key = 1;
-    for (size_t j = 0; j < uf->length; j++) {
-      if (!strcmp(uf->file_entry[j].group, ef->file_entry[i].group)) {
-        new_key = 0;
-        break;
-      }
-    }
-    if (new_key)
-      (*fe)[added_keys++] = cpy_file_entry(ef->file_entry[i]);
-  }
-  *fe = realloc(*fe, added_keys * sizeof(struct file_entry));
-  return added_keys;
-}
-
-
 #if 0
 // TODO: Make this function configureable with econf_set_opt()
 // TODO: provide the initial array from the calling function (needs to be
@@ -151,13 +79,14 @@ char **get_default_dirs(const char *usr_conf_dir, const char *etc_conf_dir) {
 }
 #endif
 
-// Check if the given directory exists. If so look for config files
-// with the given suffix
-static econf_file **
-check_conf_dir(econf_file **key_files, size_t *size, const char *path,
-	       const char *config_suffix, const char *delim, const char *comment)
+// Check if the given directory exists. If so call fct for every config
+// file with the given suffix. Files which cannot be read are skipped.
+static size_t
+check_conf_dir(const char *path, const char *config_suffix,
+	       conf_file_fct fct, void *arg)
 {
   struct dirent **de;
+  size_t found = 0;
   int num_dirs = scandir(path, &de, NULL, alphasort);
   if(num_dirs > 0) {
     for (int i = 0; i < num_dirs; i++) {
@@ -166,70 +95,383 @@ check_conf_dir(econf_file **key_files, size_t *size, const char *path,
       if (lensuffix < lenstr &&
           strncmp(de[i]->d_name + lenstr - lensuffix, config_suffix, lensuffix) == 0) {
         char *file_path = combine_strings(path, de[i]->d_name, '/');
-        econf_file *key_file;
-	econf_err error = econf_readFile(&key_file, file_path, delim, comment);
+        if (file_path && fct(file_path, false, arg) == ECONF_SUCCESS)
+          found++;
         free(file_path);
-        if(!error && key_file) {
-          key_file->on_merge_delete = 1;
-          key_files[(*size) - 1] = key_file;
-          key_files = realloc(key_files, ++(*size) * sizeof(econf_file *));
-        }
       }
       free(de[i]);
     }
     free(de);
   }
-  return key_files;
+  return found;
 }
 
-/* XXX Convert to return econf_err */
-econf_file **traverse_conf_dirs(econf_file **key_files,
-				const char *config_dirs[],
-				size_t *size, const char *path,
-				const char *config_suffix,
-				const char *delim, const char *comment) {
-  int i;
+econf_err foreach_conf_file(const char *dist_conf_dir,
+                            const char *etc_conf_dir,
+                            const char *project_name,
+                            const char *config_suffix,
+                            conf_file_fct fct, void *arg)
+{
+  const char *suffix, *default_dirs[3] = {NULL, NULL, NULL};
+  char *cp;
+  size_t found = 0;
+  econf_err error = ECONF_NOFILE;
 
-  if (config_dirs == NULL)
-    return NULL; /* XXX ECONF_ERROR */
+  // Prepend a . to the config suffix if not provided
+  if (config_suffix[0] == '.')
+    suffix = config_suffix;
+  else
+    {
+      cp = alloca (strlen(config_suffix) + 2);
+      cp[0] = '.';
+      strcpy(cp+1, config_suffix);
+      suffix = cp;
+    }
 
-  i = 0;
-  while (config_dirs[i] != NULL) {
-    char *fulldir, *cp;
+  if (etc_conf_dir != NULL)
+    {
+      char *etcfile = alloca(strlen (etc_conf_dir) + strlen (project_name) +
+                             strlen (suffix) + 2);
 
-    if ((fulldir = malloc (strlen(path) + strlen (config_dirs[i]) + 1)) == NULL)
-      return NULL;
+      cp = stpcpy (etcfile, etc_conf_dir);
+      *cp++ = '/';
+      cp = stpcpy (cp, project_name);
+      stpcpy (cp, suffix);
 
-    cp = stpcpy (fulldir, path);
-    stpcpy (cp, config_dirs[i++]);
-    key_files = check_conf_dir(key_files, size,
-        fulldir, config_suffix, delim, comment);
-    free (fulldir);
+      error = fct(etcfile, true, arg);
+      if (error && error != ECONF_NOFILE)
+        return error;
+    }
+
+  if (etc_conf_dir && !error) {
+    /* /etc/<project_name>.<suffix> does exist, ignore /usr */
+    default_dirs[0] = etc_conf_dir;
+    found++;
+  } else {
+    /* /etc/<project_name>.<suffix> does not exist, so read /usr/etc
+       and merge all *.d files. */
+    if (dist_conf_dir != NULL)
+      {
+        char *distfile = alloca(strlen (dist_conf_dir) + strlen (project_name) +
+                                strlen (suffix) + 2);
+
+        cp = stpcpy (distfile, dist_conf_dir);
+        *cp++ = '/';
+        cp = stpcpy (cp, project_name);
+        stpcpy (cp, suffix);
+
+        error = fct(distfile, true, arg);
+        if (error && error != ECONF_NOFILE)
+          return error;
+        if (!error) /* /usr/etc/<project_name>.<suffix> does exist */
+          found++;
+      }
+
+    default_dirs[0] = dist_conf_dir;
+    default_dirs[1] = etc_conf_dir;
+  }
+
+  /* XXX Re-add get_default_dirs in a reworked version, which
+     adds additional directories to look at, e.g. XDG or home directory */
+
+  for (int i = 0; default_dirs[i]; i++) {
+    /*
+      Indicate which directories to look for. The order is:
+       "default_dirs/project_name.suffix.d/"
+
+       XXX make this configureable:
+       "default_dirs/project_name/conf.d/"
+       "default_dirs/project_name.d/"
+       "default_dirs/project_name/"
+    */
+    char *project_path = combine_strings(default_dirs[i], project_name, '/');
+    char *fulldir = NULL;
+
+    if (project_path == NULL ||
+        asprintf(&fulldir, "%s%s.d/", project_path, suffix) == -1) {
+      free(project_path);
+      return ECONF_NOMEM;
+    }
+    found += check_conf_dir(fulldir, suffix, fct, arg);
+    free(fulldir);
+    free(project_path);
   }
-  return key_files;
+
+  return found ? ECONF_SUCCESS : ECONF_NOFILE;
 }
 
-econf_err merge_econf_files(econf_file **key_files, econf_file **merged_files) {
-  if (key_files == NULL || merged_files == NULL)
-    return ECONF_ERROR;
+// Merging all layers at once. The merged file consists of runs of
+// entries of the same group. Layer 0 is taken as it is. The entries of a
+// later layer change the value of a key defined by a previous layer, are
+// appended to the first run of their group if the group exists already,
+// or go into new runs after all others. Entries without group are always
+// put first.
+
+// Entry of the merged file: group and key come from entry src of layer
+// src_layer, the value from entry val of layer val_layer. next links the
+// entries of a run. hash is the key_hash() of the stored group and key
+// with fold_case of the merge, the layers may hash differently.
+struct merge_entry {
+  size_t src_layer, src, val_layer, val, next;
+  uint64_t hash;
+};
 
-  *merged_files = *key_files++;
-  if(*merged_files == NULL)
-    return ECONF_ERROR;
+struct merge_run {
+  size_t group, head, tail;
+};
 
-  while(*key_files) {
-    econf_err error;
-    econf_file *tmp = *merged_files;
+// layer is the layer which introduced the group, run its first run
+struct merge_group {
+  const char *name;
+  uint64_t hash;
+  size_t layer, run;
+};
 
-    error = econf_mergeFiles(merged_files, *merged_files, *key_files);
-    if (error || *merged_files == NULL)
-      return error;
-    (*merged_files)->on_merge_delete = 1;
+struct merge_state {
+  econf_file **layers;
+  size_t layer_length;
+  // Layers whose strings are moved into the merged file, may be NULL
+  const bool *steal;
+  // Names are matched ignoring ASCII case, the merged file gets it too
+  bool fold_case;
+  // Where the paths of each layer start in the paths of the merged file
+  uint32_t *path_offset;
+  struct merge_entry *entries;
+  struct merge_run *runs;
+  struct merge_group *groups;
+  size_t length, run_length, group_length;
+  // Open addressing tables of group and entry numbers + 1
+  size_t *group_table, *key_table, table_size;
+  int table_bits;
+};
 
-    if(tmp->on_merge_delete) { econf_free(tmp); }
-    if((*key_files)->on_merge_delete) { econf_free(*key_files); }
+#define MERGE_NONE SIZE_MAX
+
+static struct file_entry *merge_src(struct merge_state *m, size_t layer,
+                                    size_t num) {
+  return &m->layers[layer]->file_entry[num];
+}
+
+// Fibonacci hashing spreads the djb2 hash over the table
+static size_t merge_slot(struct merge_state *m, uint64_t hash) {
+  return (hash * 0x9e3779b97f4a7c15ULL) >> (64 - m->table_bits);
+}
 
-    key_files++;
+static size_t merge_find_group(struct merge_state *m, const char *name,
+                               uint64_t hash, size_t **pos) {
+  size_t i = merge_slot(m, hash);
+  while (m->group_table[i]) {
+    struct merge_group *grp = &m->groups[m->group_table[i] - 1];
+    if (grp->hash == hash && names_equal(grp->name, name, m->fold_case))
+      return m->group_table[i] - 1;
+    i = (i + 1) & (m->table_size - 1);
   }
+  *pos = &m->group_table[i];
+  return MERGE_NONE;
+}
+
+// First entry of the key of fe in the merged file
+static size_t merge_find_key(struct merge_state *m, struct file_entry *fe,
+                             uint64_t hash, size_t **pos) {
+  size_t i = merge_slot(m, hash);
+  while (m->key_table[i]) {
+    struct merge_entry *me = &m->entries[m->key_table[i] - 1];
+    struct file_entry *other = merge_src(m, me->src_layer, me->src);
+    if (me->hash == hash && names_equal(other->key, fe->key, m->fold_case) &&
+        names_equal(other->group, fe->group, m->fold_case))
+      return m->key_table[i] - 1;
+    i = (i + 1) & (m->table_size - 1);
+  }
+  *pos = &m->key_table[i];
+  return MERGE_NONE;
+}
+
+static size_t merge_new_run(struct merge_state *m, size_t group) {
+  m->runs[m->run_length] = (struct merge_run) {group, MERGE_NONE, MERGE_NONE};
+  if (m->groups[group].run == MERGE_NONE)
+    m->groups[group].run = m->run_length;
+  return m->run_length++;
+}
+
+static size_t merge_new_entry(struct merge_state *m, size_t layer, size_t num,
+                              uint64_t hash, size_t run) {
+  size_t e = m->length++;
+  m->entries[e] = (struct merge_entry) {layer, num, layer, num, MERGE_NONE,
+                                        hash};
+  if (m->runs[run].tail == MERGE_NONE)
+    m->runs[run].head = e;
+  else
+    m->entries[m->runs[run].tail].next = e;
+  m->runs[run].tail = e;
+  return e;
+}
+
+// Duplicate keys: layer 0 is taken as it is, its getters return the first
+// of them. An entry of a later layer whose key is already in the merge
+// overrides its value, so the last one of the layer wins. A key new in a
+// layer is added with all its entries and the first one is returned, as
+// when reading that file alone.
+static void merge_layer(struct merge_state *m, size_t layer) {
+  econf_file *kf = m->layers[layer];
+  // Run of the last entry copied as it is
+  size_t run = MERGE_NONE;
+
+  for (size_t n = 0; n < kf->length; n++) {
+    struct file_entry *fe = &kf->file_entry[n];
+    uint64_t hash = key_hash(fe->group, "", m->fold_case);
+    size_t *pos = NULL, *key_pos = NULL;
+    size_t group = merge_find_group(m, fe->group, hash, &pos);
+    if (group == MERGE_NONE) {
+      group = m->group_length++;
+      m->groups[group] = (struct merge_group) {fe->group, hash, layer,
+                                               MERGE_NONE};
+      *pos = group + 1;
+    }
+
+    uint64_t key = key_hash(fe->group, fe->key, m->fold_case);
+    size_t e = merge_find_key(m, fe, key, &key_pos);
+    if (m->groups[group].layer == layer) {
+      // Layer 0 and groups new in this layer are copied as they are
+      if (run == MERGE_NONE || m->runs[run].group != group)
+        run = merge_new_run(m, group);
+      size_t added = merge_new_entry(m, layer, n, key, run);
+      if (e == MERGE_NONE)
+        *key_pos = added + 1;
+    } else if (e != MERGE_NONE && m->entries[e].src_layer < layer) {
+      // Override the value of a previous layer, the last entry wins
+      m->entries[e].val_layer = layer;
+      m->entries[e].val = n;
+    } else {
+      size_t added = merge_new_entry(m, layer, n, key, m->groups[group].run);
+      if (e == MERGE_NONE)
+        *key_pos = added + 1;
+    }
+  }
+}
+
+// Move the string out of a stolen layer or share it. Every entry of a
+// layer ends up in the merged file at most once, as src or as val. The
+// strings of frozen layers are no refstrs and have to be copied.
+static char *merge_string(struct merge_state *m, size_t layer, char **str) {
+  if (*str == NULL)
+    return NULL;
+  if (m->layers[layer]->frozen)
+    return refstr_new(*str);
+  if (m->steal && m->steal[layer]) {
+    char *ret = *str;
+    *str = NULL;
+    return ret;
+  }
+  return refstr_ref(*str);
+}
+
+// Copy the entries of run into fe starting at *length
+static econf_err merge_copy_run(struct merge_state *m, size_t run,
+                                struct file_entry *fe, size_t *length) {
+  for (size_t e = m->runs[run].head; e != MERGE_NONE; e = m->entries[e].next) {
+    struct merge_entry *me = &m->entries[e];
+    struct file_entry *src = merge_src(m, me->src_layer, me->src);
+    struct file_entry *val = merge_src(m, me->val_layer, me->val);
+    struct file_entry *dest = &fe[(*length)++];
+    bool has_value = val->value != NULL;
+
+    memset(dest, 0, sizeof(*dest));
+    dest->group = merge_string(m, me->src_layer, &src->group);
+    dest->key = merge_string(m, me->src_layer, &src->key);
+    dest->value = merge_string(m, me->val_layer, &val->value);
+    // Provenance is that of the value, the key may be defined earlier
+    dest->line_number = val->line_number;
+    dest->source = val->source == KEY_FILE_NO_SOURCE ? KEY_FILE_NO_SOURCE :
+                   m->path_offset[me->val_layer] + val->source;
+    if (!dest->group || !dest->key || (has_value && !dest->value))
+      return ECONF_NOMEM;
+  }
+  return ECONF_SUCCESS;
+}
+
+static econf_err merge_build(struct merge_state *m, econf_file **merged) {
+  econf_file *kf = calloc(1, sizeof(econf_file));
+  if (kf == NULL)
+    return ECONF_NOMEM;
+  kf->delimiter = m->layers[0]->delimiter;
+  kf->comment = m->layers[0]->comment;
+  kf->fold_case = m->fold_case;
+  new_generation(kf);
+  kf->file_entry = calloc(m->length ? m->length : 1, sizeof(struct file_entry));
+  kf->alloc_length = m->length;
+  size_t path_length = 0;
+  for (size_t l = 0; l < m->layer_length; l++)
+    path_length += m->layers[l]->path_length;
+  kf->paths = malloc((path_length ? path_length : 1) * sizeof(char *));
+  if (kf->file_entry == NULL || kf->paths == NULL) {
+    econf_freeFile(kf);
+    return ECONF_NOMEM;
+  }
+  // The paths are shared, only the entries refer to them by number
+  for (size_t l = 0; l < m->layer_length; l++) {
+    econf_file *layer = m->layers[l];
+    m->path_offset[l] = kf->path_length;
+    for (size_t i = 0; i < layer->path_length; i++)
+      kf->paths[kf->path_length++] = refstr_ref(layer->paths[i]);
+  }
+
+  size_t *pos, first = MERGE_NONE;
+  size_t nogroup = merge_find_group(m, KEY_FILE_NULL_VALUE,
+                                    key_hash(KEY_FILE_NULL_VALUE, "",
+                                             m->fold_case),
+                                    &pos);
+  econf_err error = ECONF_SUCCESS;
+  if (nogroup != MERGE_NONE) {
+    first = m->groups[nogroup].run;
+    error = merge_copy_run(m, first, kf->file_entry, &kf->length);
+  }
+  for (size_t r = 0; !error && r < m->run_length; r++)
+    if (r != first)
+      error = merge_copy_run(m, r, kf->file_entry, &kf->length);
+  if (!error)
+    error = index_build(kf);
+  if (error) {
+    econf_freeFile(kf);
+    return error;
+  }
+  *merged = kf;
   return ECONF_SUCCESS;
 }
+
+econf_err merge_files(econf_file **key_files, size_t length,
+                      const bool *steal, bool fold_case,
+                      econf_file **merged_file) {
+  size_t total = 0;
+  for (size_t i = 0; i < length; i++)
+    total += key_files[i]->length;
+
+  struct merge_state m = {.layers = key_files, .layer_length = length,
+                          .steal = steal, .fold_case = fold_case,
+                          .table_size = 2, .table_bits = 1};
+  while (m.table_size < 2 * total) {
+    m.table_size *= 2;
+    m.table_bits++;
+  }
+  size_t size = total ? total : 1;
+  m.entries = malloc(size * sizeof(struct merge_entry));
+  m.runs = malloc(size * sizeof(struct merge_run));
+  m.groups = malloc(size * sizeof(struct merge_group));
+  m.group_table = calloc(m.table_size, sizeof(size_t));
+  m.key_table = calloc(m.table_size, sizeof(size_t));
+  m.path_offset = malloc((length ? length : 1) * sizeof(uint32_t));
+
+  econf_err error = ECONF_NOMEM;
+  if (m.entries && m.runs && m.groups && m.group_table && m.key_table &&
+      m.path_offset) {
+    for (size_t i = 0; i < length; i++)
+      merge_layer(&m, i);
+    error = merge_build(&m, merged_file);
+  }
+  free(m.entries);
+  free(m.runs);
+  free(m.groups);
+  free(m.group_table);
+  free(m.key_table);
+  free(m.path_offset);
+  return error;
+}
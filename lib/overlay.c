@@ -0,0 +1,206 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "libeconf.h"
+#include "../include/helpers.h"
+#include "../include/keyfile.h"
+#include "../include/keyindex.h"
+#include "../include/mergefiles.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Layer files in order of increasing priority, all owned by the overlay
+struct econf_overlay {
+  econf_file **layers;
+  size_t length, alloc_length;
+};
+
+econf_err econf_newOverlay(econf_overlay **result) {
+  if (result == NULL)
+    return ECONF_ERROR;
+
+  *result = calloc(1, sizeof(econf_overlay));
+  if (*result == NULL)
+    return ECONF_NOMEM;
+  return ECONF_SUCCESS;
+}
+
+econf_err econf_overlayAddLayer(econf_overlay *ov, econf_file *layer) {
+  if (!ov || !layer)
+    return ECONF_ERROR;
+
+  if (ov->length == ov->alloc_length) {
+    size_t length = ov->alloc_length ? 2 * ov->alloc_length : 4;
+    econf_file **tmp = realloc(ov->layers, length * sizeof(econf_file *));
+    if (tmp == NULL)
+      return ECONF_NOMEM;
+    ov->layers = tmp;
+    ov->alloc_length = length;
+  }
+  ov->layers[ov->length++] = layer;
+  return ECONF_SUCCESS;
+}
+
+econf_err econf_overlaySetLayer(econf_overlay *ov, size_t pos,
+                                econf_file *layer) {
+  if (!ov || !layer || pos >= ov->length)
+    return ECONF_ERROR;
+
+  if (ov->layers[pos] != layer)
+    econf_freeFile(ov->layers[pos]);
+  ov->layers[pos] = layer;
+  return ECONF_SUCCESS;
+}
+
+econf_err econf_overlayLength(econf_overlay *ov, size_t *length) {
+  if (!ov || length == NULL)
+    return ECONF_ERROR;
+
+  *length = ov->length;
+  return ECONF_SUCCESS;
+}
+
+void econf_freeOverlay(econf_overlay *ov) {
+  if (!ov)
+    return;
+
+  for (size_t i = 0; i < ov->length; i++)
+    econf_freeFile(ov->layers[i]);
+  free(ov->layers);
+  free(ov);
+}
+
+// Config files read by econf_readDirsOverlay()
+struct overlay_files {
+  econf_overlay *ov;
+  const char *delim;
+  const char *comment;
+};
+
+static econf_err add_conf_file(const char *path,
+                               bool main_file __attribute__((unused)),
+                               void *arg) {
+  struct overlay_files *of = arg;
+  econf_file *key_file;
+  econf_err error = econf_readFile(&key_file, path, of->delim, of->comment);
+  if (error)
+    return error;
+  if ((error = econf_overlayAddLayer(of->ov, key_file)))
+    econf_freeFile(key_file);
+  return error;
+}
+
+econf_err econf_readDirsOverlay(econf_overlay **result,
+                                const char *dist_conf_dir,
+                                const char *etc_conf_dir,
+                                const char *project_name,
+                                const char *config_suffix,
+                                const char *delim,
+                                const char *comment) {
+  if (result == NULL || config_suffix == NULL || !*config_suffix ||
+      project_name == NULL || !*project_name || delim == NULL)
+    return ECONF_ERROR;
+
+  econf_err error = econf_newOverlay(result);
+  if (error)
+    return error;
+
+  struct overlay_files of = {*result, delim, comment};
+  error = foreach_conf_file(dist_conf_dir, etc_conf_dir, project_name,
+                            config_suffix, add_conf_file, &of);
+  if (error) {
+    econf_freeOverlay(*result);
+    *result = NULL;
+  }
+  return error;
+}
+
+// Find the entry econf_readDirs() would return for group and key. The
+// highest layer defining the key wins. If it overrides the key of a lower
+// layer, merging assigns each of its entries in turn, so the last one
+// defines the value; otherwise the entries are appended and the first
+// one is found.
+static econf_err overlay_find(econf_overlay *ov, const char *group,
+                              const char *key, econf_file **kf,
+                              size_t *num) {
+  if (!key || !*key)
+    return ECONF_ERROR;
+
+  for (size_t i = ov->length; i-- > 0; ) {
+    econf_err error = index_find_key(ov->layers[i], group, key, num);
+    if (error == ECONF_NOKEY)
+      continue;
+    if (error)
+      return error;
+
+    *kf = ov->layers[i];
+    for (size_t j = i; j-- > 0; ) {
+      size_t lower;
+      if (index_find_key(ov->layers[j], group, key, &lower) == ECONF_SUCCESS) {
+        *num = (*kf)->file_entry[*num].last;
+        break;
+      }
+    }
+    return ECONF_SUCCESS;
+  }
+  return ECONF_NOKEY;
+}
+
+#define econf_overlayGetValue(FCT_TYPE, TYPE) \
+econf_err econf_overlayGet ## FCT_TYPE ## Value(econf_overlay *ov, \
+                                                const char *group, \
+                                                const char *key, \
+                                                TYPE *result) { \
+  econf_file *kf; \
+  size_t num; \
+  if (!ov) \
+    return ECONF_ERROR; \
+  econf_err error = overlay_find(ov, group, key, &kf, &num); \
+  if (error) \
+    return error; \
+  return get ## FCT_TYPE ## ValueNum(*kf, num, result); \
+}
+
+econf_overlayGetValue(Int, int32_t)
+econf_overlayGetValue(Int64, int64_t)
+econf_overlayGetValue(UInt, uint32_t)
+econf_overlayGetValue(UInt64, uint64_t)
+econf_overlayGetValue(Float, float)
+econf_overlayGetValue(Double, double)
+econf_overlayGetValue(String, char *)
+econf_overlayGetValue(Bool, bool)
+
+econf_err econf_overlayGetStringValueRef(econf_overlay *ov, const char *group,
+                                         const char *key,
+                                         const char **result) {
+  econf_file *kf;
+  size_t num;
+  if (!ov || result == NULL)
+    return ECONF_ERROR;
+
+  econf_err error = overlay_find(ov, group, key, &kf, &num);
+  if (error)
+    return error;
+  *result = kf->file_entry[num].value;
+  return ECONF_SUCCESS;
+}
@@ -0,0 +1,358 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "../include/parsenum.h"
+
+#include <locale.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_DIGITS 19 /* all numbers with 19 digits fit into uint64_t */
+
+/* Exactly representable powers of ten, see parse_real() */
+static const double pow10_double[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const float pow10_float[] = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+static bool is_blank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+// Skip leading blanks and return the length without trailing blanks
+static const char *trim(const char *string, size_t *length) {
+  while (is_blank(*string))
+    string++;
+  *length = strlen(string);
+  while (*length && is_blank(string[*length - 1]))
+    (*length)--;
+  return string;
+}
+
+// Convert the digits of string into magnitude, failing on overflow
+static econf_err parse_digits(const char *string, size_t length,
+                              uint64_t *magnitude) {
+  uint64_t value = 0;
+
+  if (!length)
+    return ECONF_PARSE_ERROR;
+  for (size_t i = 0; i < length; i++) {
+    unsigned digit = (unsigned char) string[i] - '0';
+    if (digit > 9)
+      return ECONF_PARSE_ERROR;
+    if (value > (UINT64_MAX - digit) / 10)
+      return ECONF_PARSE_ERROR;
+    value = value * 10 + digit;
+  }
+  *magnitude = value;
+  return ECONF_SUCCESS;
+}
+
+econf_err parse_signed(const char *string, int64_t min, int64_t max,
+                       int64_t *result) {
+  size_t length;
+  bool negative = false;
+  uint64_t magnitude;
+
+  if (string == NULL)
+    return ECONF_EMPTYKEY;
+  string = trim(string, &length);
+  if (!length)
+    return ECONF_EMPTYKEY;
+
+  if (*string == '-' || *string == '+') {
+    negative = *string == '-';
+    string++;
+    length--;
+  }
+  econf_err error = parse_digits(string, length, &magnitude);
+  if (error)
+    return error;
+
+  if (negative) {
+    // -(min + 1) + 1 avoids the overflow of -INT64_MIN
+    if (min > 0 || magnitude > (uint64_t) -(min + 1) + 1)
+      return ECONF_PARSE_ERROR;
+    *result = magnitude ? -(int64_t) (magnitude - 1) - 1 : 0;
+  } else {
+    if (max < 0 || magnitude > (uint64_t) max)
+      return ECONF_PARSE_ERROR;
+    *result = (int64_t) magnitude;
+  }
+  return ECONF_SUCCESS;
+}
+
+econf_err parse_unsigned(const char *string, uint64_t max, uint64_t *result) {
+  size_t length;
+  uint64_t magnitude;
+
+  if (string == NULL)
+    return ECONF_EMPTYKEY;
+  string = trim(string, &length);
+  if (!length)
+    return ECONF_EMPTYKEY;
+
+  if (*string == '+') {
+    string++;
+    length--;
+  }
+  econf_err error = parse_digits(string, length, &magnitude);
+  if (error)
+    return error;
+  if (magnitude > max)
+    return ECONF_PARSE_ERROR;
+
+  *result = magnitude;
+  return ECONF_SUCCESS;
+}
+
+/* The decimal number of a string: mantissa * 10^exponent. Digits beyond
+   the first MAX_DIGITS are only counted in truncated.  */
+struct decimal {
+  bool negative, truncated;
+  uint64_t mantissa;
+  int64_t exponent;
+};
+
+// Check the syntax of a floating point number and split it up
+static econf_err scan_real(const char *string, size_t length,
+                           struct decimal *dec) {
+  const char *end = string + length;
+  size_t digits = 0, significant = 0;
+
+  dec->negative = false;
+  dec->truncated = false;
+  dec->mantissa = 0;
+  dec->exponent = 0;
+
+  if (*string == '-' || *string == '+')
+    dec->negative = *string++ == '-';
+
+  for (bool fraction = false; string < end; string++) {
+    unsigned digit = (unsigned char) *string - '0';
+    if (*string == '.' && !fraction) {
+      fraction = true;
+      continue;
+    }
+    if (digit > 9)
+      break;
+    digits++;
+    if (!significant && !digit) {
+      // leading zeros only move the decimal point
+      if (fraction)
+        dec->exponent--;
+      continue;
+    }
+    if (significant < MAX_DIGITS) {
+      dec->mantissa = dec->mantissa * 10 + digit;
+      significant++;
+      if (fraction)
+        dec->exponent--;
+    } else {
+      dec->truncated |= digit != 0;
+      if (!fraction)
+        dec->exponent++;
+    }
+  }
+  if (!digits)
+    return ECONF_PARSE_ERROR;
+
+  if (string < end && (*string == 'e' || *string == 'E')) {
+    bool negative = false;
+    int64_t exponent = 0;
+
+    string++;
+    if (string < end && (*string == '-' || *string == '+'))
+      negative = *string++ == '-';
+    if (string == end)
+      return ECONF_PARSE_ERROR;
+    for (; string < end; string++) {
+      unsigned digit = (unsigned char) *string - '0';
+      if (digit > 9)
+        return ECONF_PARSE_ERROR;
+      // everything beyond this is infinite or zero anyway
+      if (exponent < 100000)
+        exponent = exponent * 10 + digit;
+    }
+    dec->exponent += negative ? -exponent : exponent;
+  }
+  return string == end ? ECONF_SUCCESS : ECONF_PARSE_ERROR;
+}
+
+// Check for "inf", "infinity" and "nan" with an optional sign
+static bool parse_special(const char *string, size_t length, double *result) {
+  bool negative = false;
+
+  if (*string == '-' || *string == '+') {
+    negative = *string++ == '-';
+    length--;
+  }
+  if ((length == 3 && !strncasecmp(string, "inf", 3)) ||
+      (length == 8 && !strncasecmp(string, "infinity", 8)))
+    *result = negative ? -HUGE_VAL : HUGE_VAL;
+  else if (length == 3 && !strncasecmp(string, "nan", 3))
+    *result = negative ? -NAN : NAN;
+  else
+    return false;
+  return true;
+}
+
+#ifdef HAVE_STRTOD_L
+static locale_t c_locale(void) {
+  static locale_t locale = (locale_t) 0;
+  locale_t current = __atomic_load_n(&locale, __ATOMIC_ACQUIRE);
+
+  if (current == (locale_t) 0) {
+    locale_t created = newlocale(LC_ALL_MASK, "C", (locale_t) 0);
+    if (created == (locale_t) 0)
+      return (locale_t) 0;
+    if (__atomic_compare_exchange_n(&locale, &current, created, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+      current = created;
+    else
+      freelocale(created);
+  }
+  return current;
+}
+#endif
+
+// Convert a string already checked by scan_real() with the C library in
+// the C locale. Without strtod_l() strtod() uses the decimal point of the
+// current locale, so it replaces the '.' accepted by scan_real().
+static econf_err parse_libc(const char *string, size_t length, bool is_float,
+                            double *result) {
+#ifdef HAVE_STRTOD_L
+  const char *point = ".";
+#else
+  const char *point = localeconv()->decimal_point;
+#endif
+  size_t point_length = strlen(point);
+  char buffer[128];
+  char *copy = length + point_length < sizeof(buffer) ? buffer :
+               malloc(length + point_length + 1);
+
+  if (copy == NULL)
+    return ECONF_NOMEM;
+  const char *dot = memchr(string, '.', length);
+  if (dot == NULL) {
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+  } else {
+    size_t before = dot - string;
+    memcpy(copy, string, before);
+    memcpy(copy + before, point, point_length);
+    memcpy(copy + before + point_length, dot + 1, length - before - 1);
+    copy[length - 1 + point_length] = '\0';
+  }
+#ifdef HAVE_STRTOD_L
+  locale_t locale = c_locale();
+  if (locale == (locale_t) 0) {
+    if (copy != buffer)
+      free(copy);
+    return ECONF_NOMEM;
+  }
+  *result = is_float ? strtof_l(copy, NULL, locale) :
+                       strtod_l(copy, NULL, locale);
+#else
+  *result = is_float ? strtof(copy, NULL) : strtod(copy, NULL);
+#endif
+  if (copy != buffer)
+    free(copy);
+  return ECONF_SUCCESS;
+}
+
+// Convert string, the fast path is exact if both the mantissa and the
+// power of ten are exactly representable (Clinger's fast path).
+static econf_err parse_real(const char *string, bool is_float,
+                            double *result) {
+  struct decimal dec;
+  size_t length;
+  econf_err error;
+
+  if (string == NULL)
+    return ECONF_EMPTYKEY;
+  string = trim(string, &length);
+  if (!length)
+    return ECONF_EMPTYKEY;
+
+  if (parse_special(string, length, result))
+    return ECONF_SUCCESS;
+  if ((error = scan_real(string, length, &dec)))
+    return error;
+
+  if (dec.mantissa == 0) {
+    *result = dec.negative ? -0.0 : 0.0;
+    return ECONF_SUCCESS;
+  }
+  if (!dec.truncated) {
+    if (is_float && dec.mantissa < (1 << 24) &&
+        dec.exponent >= -10 && dec.exponent <= 10) {
+      float value = dec.mantissa;
+      if (dec.exponent < 0)
+        value /= pow10_float[-dec.exponent];
+      else
+        value *= pow10_float[dec.exponent];
+      *result = dec.negative ? -value : value;
+      return ECONF_SUCCESS;
+    }
+    if (!is_float && dec.mantissa < (1ULL << 53) &&
+        dec.exponent >= -22 && dec.exponent <= 22) {
+      double value = dec.mantissa;
+      if (dec.exponent < 0)
+        value /= pow10_double[-dec.exponent];
+      else
+        value *= pow10_double[dec.exponent];
+      *result = dec.negative ? -value : value;
+      return ECONF_SUCCESS;
+    }
+  }
+
+  if ((error = parse_libc(string, length, is_float, result)))
+    return error;
+  // The value does not fit into the type
+  if (isinf(*result))
+    return ECONF_PARSE_ERROR;
+  return ECONF_SUCCESS;
+}
+
+econf_err parse_double(const char *string, double *result) {
+  double value;
+  econf_err error = parse_real(string, false, &value);
+
+  if (error == ECONF_SUCCESS)
+    *result = value;
+  return error;
+}
+
+econf_err parse_float(const char *string, float *result) {
+  double value;
+  econf_err error = parse_real(string, true, &value);
+
+  if (error == ECONF_SUCCESS)
+    *result = value;
+  return error;
+}
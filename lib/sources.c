@@ -0,0 +1,313 @@
+/*
+  Copyright (C) 2026 SUSE LLC
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "libeconf.h"
+#include "../include/defines.h"
+#include "../include/helpers.h"
+#include "../include/keyindex.h"
+#include "../include/mergefiles.h"
+#include "../include/sources.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char *dup_arg(const char *arg, bool *failed) {
+  char *ret = arg ? strdup(arg) : NULL;
+  if (arg && !ret)
+    *failed = true;
+  return ret;
+}
+
+econf_err sources_new(struct econf_sources **result,
+                      const char *dist_conf_dir, const char *etc_conf_dir,
+                      const char *project_name, const char *config_suffix,
+                      const char *delim, const char *comment) {
+  struct econf_sources *s = calloc(1, sizeof(struct econf_sources));
+  if (s == NULL)
+    return ECONF_NOMEM;
+
+  bool failed = false;
+  s->dist_conf_dir = dup_arg(dist_conf_dir, &failed);
+  s->etc_conf_dir = dup_arg(etc_conf_dir, &failed);
+  s->project_name = dup_arg(project_name, &failed);
+  s->config_suffix = dup_arg(config_suffix, &failed);
+  s->delim = dup_arg(delim, &failed);
+  s->comment = dup_arg(comment, &failed);
+  if (failed) {
+    sources_free(s);
+    return ECONF_NOMEM;
+  }
+  *result = s;
+  return ECONF_SUCCESS;
+}
+
+// State of one sources_scan(): the files found so far and which of the
+// old ones are used again
+struct scan {
+  struct econf_sources *old;
+  struct econf_source *files;
+  size_t length, alloc_length;
+  bool *reused;
+  // Where to start looking for the next file among the old ones
+  size_t next;
+  bool changed;
+};
+
+static bool same_stat(const struct econf_source *src, const struct stat *st) {
+  return src->dev == st->st_dev && src->ino == st->st_ino &&
+         src->size == st->st_size &&
+         src->mtime.tv_sec == st->st_mtim.tv_sec &&
+         src->mtime.tv_nsec == st->st_mtim.tv_nsec &&
+         src->ctime.tv_sec == st->st_ctim.tv_sec &&
+         src->ctime.tv_nsec == st->st_ctim.tv_nsec;
+}
+
+// Old file read from path, unless it is used already. The files are
+// usually found in the same order as before, so the search starts after
+// the last match.
+static size_t find_old(struct scan *sc, const char *path) {
+  size_t length = sc->old->length;
+  for (size_t n = 0; n < length; n++) {
+    size_t i = (sc->next + n) % length;
+    if (!sc->reused[i] && !strcmp(sc->old->files[i].layer->path, path))
+      return i;
+  }
+  return SIZE_MAX;
+}
+
+static econf_err scan_conf_file(const char *path,
+                                bool main_file __attribute__((unused)),
+                                void *arg) {
+  struct scan *sc = arg;
+  struct stat st;
+
+  if (sc->length == sc->alloc_length) {
+    size_t alloc_length = sc->alloc_length ? 2 * sc->alloc_length : 16;
+    struct econf_source *tmp = realloc(sc->files,
+                                       alloc_length * sizeof(*tmp));
+    if (tmp == NULL)
+      return ECONF_NOMEM;
+    sc->files = tmp;
+    sc->alloc_length = alloc_length;
+  }
+  // A file changing between stat() and reading it is read again by the
+  // next scan, as its stat data differs then
+  if (stat(path, &st))
+    return ECONF_NOFILE;
+
+  size_t i = find_old(sc, path);
+  if (i != SIZE_MAX && same_stat(&sc->old->files[i], &st)) {
+    sc->reused[i] = true;
+    sc->next = i + 1;
+    if (i != sc->length)
+      sc->changed = true;
+    sc->files[sc->length++] = sc->old->files[i];
+    return ECONF_SUCCESS;
+  }
+
+  econf_file *layer;
+  econf_err error = econf_readFile(&layer, path, sc->old->delim,
+                                   sc->old->comment);
+  if (error)
+    return error;
+  // Merging doesn't need the index of its inputs
+  index_free(layer);
+  sc->changed = true;
+  sc->files[sc->length++] = (struct econf_source) {
+    layer, st.st_dev, st.st_ino, st.st_size, st.st_mtim, st.st_ctim
+  };
+  return ECONF_SUCCESS;
+}
+
+// Whether layer is one of the files the scan started with
+static bool is_old(struct scan *sc, econf_file *layer) {
+  for (size_t i = 0; i < sc->old->length; i++)
+    if (sc->old->files[i].layer == layer)
+      return true;
+  return false;
+}
+
+econf_err sources_scan(struct econf_sources *sources, bool *changed) {
+  struct scan sc = {.old = sources};
+  sc.reused = calloc(sources->length ? sources->length : 1, sizeof(bool));
+  if (sc.reused == NULL)
+    return ECONF_NOMEM;
+
+  econf_err error = foreach_conf_file(sources->dist_conf_dir,
+                                      sources->etc_conf_dir,
+                                      sources->project_name,
+                                      sources->config_suffix,
+                                      scan_conf_file, &sc);
+  if (error) {
+    for (size_t i = 0; i < sc.length; i++)
+      if (!is_old(&sc, sc.files[i].layer))
+        econf_freeFile(sc.files[i].layer);
+    free(sc.files);
+    free(sc.reused);
+    return error;
+  }
+
+  for (size_t i = 0; i < sources->length; i++)
+    if (!sc.reused[i]) {
+      econf_freeFile(sources->files[i].layer);
+      sc.changed = true;
+    }
+  free(sources->files);
+  free(sc.reused);
+  sources->files = sc.files;
+  sources->length = sc.length;
+  sources->dirty |= sc.changed;
+  *changed = sources->dirty;
+  return ECONF_SUCCESS;
+}
+
+econf_err sources_merge(struct econf_sources *sources, econf_file **merged,
+                        bool steal) {
+  size_t size = sources->length ? sources->length : 1;
+  econf_file **layers = malloc(size * sizeof(econf_file *));
+  bool *stolen = steal ? malloc(size * sizeof(bool)) : NULL;
+  if (layers == NULL || (steal && stolen == NULL)) {
+    free(layers);
+    free(stolen);
+    return ECONF_NOMEM;
+  }
+  for (size_t i = 0; i < sources->length; i++) {
+    layers[i] = sources->files[i].layer;
+    if (stolen)
+      stolen[i] = true;
+  }
+
+  econf_err error = merge_files(layers, sources->length, stolen, false,
+                                merged);
+  free(layers);
+  free(stolen);
+  if (!error)
+    sources->dirty = false;
+  return error;
+}
+
+void sources_free(struct econf_sources *sources) {
+  if (sources == NULL)
+    return;
+  for (size_t i = 0; i < sources->length; i++)
+    econf_freeFile(sources->files[i].layer);
+  free(sources->files);
+  free(sources->dist_conf_dir);
+  free(sources->etc_conf_dir);
+  free(sources->project_name);
+  free(sources->config_suffix);
+  free(sources->delim);
+  free(sources->comment);
+  free(sources);
+}
+
+econf_err econf_refresh(econf_file *key_file) {
+  if (key_file == NULL)
+    return ECONF_ERROR;
+  if (key_file->frozen)
+    return ECONF_FROZEN;
+  if (key_file->sources == NULL)
+    return ECONF_ERROR;
+
+  bool changed;
+  econf_err error = sources_scan(key_file->sources, &changed);
+  if (error || !changed)
+    return error;
+
+  econf_file *merged;
+  if ((error = sources_merge(key_file->sources, &merged, false)))
+    return error;
+  move_file_contents(key_file, merged);
+  return ECONF_SUCCESS;
+}
+
+// Projects of one econf_readDirsMulti() call, handed out to the threads
+// by incrementing next
+struct read_multi {
+  const econf_project *projects;
+  size_t n, next;
+  const char *dist_conf_dir, *etc_conf_dir, *delim, *comment;
+  unsigned int flags;
+  econf_file **results;
+  econf_err *status;
+};
+
+static void *read_projects(void *arg) {
+  struct read_multi *rm = arg;
+
+  for (;;) {
+    size_t i = __atomic_fetch_add(&rm->next, 1, __ATOMIC_RELAXED);
+    if (i >= rm->n)
+      break;
+    rm->status[i] = econf_readDirsWithFlags(&rm->results[i],
+                                            rm->dist_conf_dir,
+                                            rm->etc_conf_dir,
+                                            rm->projects[i].project_name,
+                                            rm->projects[i].config_suffix,
+                                            rm->delim, rm->comment,
+                                            rm->flags);
+  }
+  return NULL;
+}
+
+econf_err econf_readDirsMulti(econf_file **results, econf_err *status,
+                              const econf_project *projects, size_t n,
+                              const char *dist_conf_dir,
+                              const char *etc_conf_dir,
+                              const char *delim, const char *comment,
+                              unsigned int threads, unsigned int flags) {
+  if (results == NULL || (projects == NULL && n) || delim == NULL ||
+      (flags & ~ECONF_REFRESHABLE))
+    return ECONF_ERROR;
+  if (n == 0)
+    return ECONF_SUCCESS;
+
+  struct read_multi rm = {projects, n, 0, dist_conf_dir, etc_conf_dir,
+                          delim, comment, flags, results, status};
+  if (status == NULL && (rm.status = malloc(n * sizeof(econf_err))) == NULL)
+    return ECONF_NOMEM;
+  for (size_t i = 0; i < n; i++)
+    results[i] = NULL;
+
+  // The calling thread reads as well. If a thread can't be started, the
+  // others read its share.
+  if (threads > n)
+    threads = n;
+  pthread_t *tids = threads > 1 ? malloc((threads - 1) * sizeof(pthread_t)) :
+                    NULL;
+  unsigned int started = 0;
+  while (tids != NULL && started < threads - 1 &&
+         !pthread_create(&tids[started], NULL, read_projects, &rm))
+    started++;
+  read_projects(&rm);
+  for (unsigned int t = 0; t < started; t++)
+    pthread_join(tids[t], NULL);
+  free(tids);
+
+  econf_err error = ECONF_SUCCESS;
+  for (size_t i = 0; i < n && !error; i++)
+    error = rm.status[i];
+  if (status == NULL)
+    free(rm.status);
+  return error;
+}
@@ -0,0 +1,137 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Fill a settings struct from a vendor config, drop-ins of the vendor and
+   of the administrator and a broken drop-in, once with econf_readDirs()
+   and econf_bind() and once with econf_readDirsInto(). Both must give
+   the same result as reading the values one by one.
+*/
+
+struct settings {
+  char *name;
+  char *user;
+  bool debug;
+  int32_t max_conn;
+  int64_t max_size;
+  uint32_t workers;
+  uint64_t max_bytes;
+  float idle;
+  double connect;
+};
+
+static const char def_user[] = "nobody";
+static const uint64_t def_max_bytes = 4096;
+
+static const econf_field schema[] = {
+  {NULL, "Name", ECONF_TYPE_STRING, offsetof(struct settings, name), NULL},
+  {NULL, "User", ECONF_TYPE_STRING, offsetof(struct settings, user), def_user},
+  {"", "Debug", ECONF_TYPE_BOOL, offsetof(struct settings, debug), NULL},
+  {"Limits", "MaxConn", ECONF_TYPE_INT, offsetof(struct settings, max_conn), NULL},
+  {"[Limits]", "MaxSize", ECONF_TYPE_INT64, offsetof(struct settings, max_size), NULL},
+  {"Limits", "Workers", ECONF_TYPE_UINT, offsetof(struct settings, workers), NULL},
+  {"Limits", "MaxBytes", ECONF_TYPE_UINT64, offsetof(struct settings, max_bytes), &def_max_bytes},
+  {"Timeouts", "Idle", ECONF_TYPE_FLOAT, offsetof(struct settings, idle), NULL},
+  {"Timeouts", "Connect", ECONF_TYPE_DOUBLE, offsetof(struct settings, connect), NULL},
+};
+#define FIELDS (sizeof(schema) / sizeof(schema[0]))
+
+static int
+check_settings (const char *test, struct settings *s, econf_err *status)
+{
+  int retval = 0;
+
+  for (size_t i = 0; i < FIELDS; i++)
+    {
+      econf_err expected = (i == 1 || i == 6) ? ECONF_NOKEY : ECONF_SUCCESS;
+      if (status[i] != expected)
+	{
+	  fprintf (stderr, "ERROR: %s: %s returned '%s'\n", test,
+		   schema[i].key, econf_errString(status[i]));
+	  retval = 1;
+	}
+    }
+
+  if (!s->name || strcmp(s->name, "server") != 0 ||
+      !s->user || strcmp(s->user, "nobody") != 0)
+    {
+      fprintf (stderr, "ERROR: %s: wrong strings '%s', '%s'\n", test,
+	       s->name ? s->name : "NULL", s->user ? s->user : "NULL");
+      retval = 1;
+    }
+  if (s->debug || s->max_conn != 42 || s->max_size != INT64_MAX ||
+      s->workers != 4 || s->max_bytes != 4096 || s->idle != 0.5 ||
+      s->connect != 3)
+    {
+      fprintf (stderr, "ERROR: %s: wrong values %d %d %lld %u %llu %g %g\n",
+	       test, s->debug, s->max_conn, (long long) s->max_size, s->workers,
+	       (unsigned long long) s->max_bytes, s->idle, s->connect);
+      retval = 1;
+    }
+  free (s->name);
+  free (s->user);
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  struct settings s;
+  econf_err error, status[FIELDS];
+  int retval = 0;
+
+  error = econf_readDirs (&key_file,
+			  TESTSDIR"tst-bind1-data/usr/etc",
+			  TESTSDIR"tst-bind1-data/etc",
+			  "bind", "conf", "=", "#");
+  if (error)
+    {
+      fprintf (stderr, "ERROR: econf_readDirs: %s\n", econf_errString(error));
+      return 1;
+    }
+  memset (&s, 0, sizeof(s));
+  if ((error = econf_bind (key_file, schema, FIELDS, &s, status)))
+    {
+      fprintf (stderr, "ERROR: econf_bind: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  retval |= check_settings ("econf_bind", &s, status);
+  econf_free (key_file);
+
+  memset (&s, 0xff, sizeof(s));
+  error = econf_readDirsInto (schema, FIELDS, &s, status,
+			      TESTSDIR"tst-bind1-data/usr/etc",
+			      TESTSDIR"tst-bind1-data/etc",
+			      "bind", "conf", "=", "#");
+  if (error)
+    {
+      fprintf (stderr, "ERROR: econf_readDirsInto: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  retval |= check_settings ("econf_readDirsInto", &s, status);
+
+  /* Missing keys without default are reported */
+  const econf_field missing[] = {
+    {"Limits", "Missing", ECONF_TYPE_INT, offsetof(struct settings, max_conn), NULL},
+  };
+  error = econf_readDirsInto (missing, 1, &s, NULL,
+			      TESTSDIR"tst-bind1-data/usr/etc",
+			      TESTSDIR"tst-bind1-data/etc",
+			      "bind", "conf", "=", "#");
+  if (error != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: missing key returned: %s\n", econf_errString(error));
+      retval = 1;
+    }
+
+  return retval;
+}
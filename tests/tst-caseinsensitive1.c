@@ -0,0 +1,127 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Read a file with ECONF_CASE_INSENSITIVE and check that groups and keys
+   are found regardless of their case, that groups and keys differing only
+   in case are the same and that a file read without the flag still
+   distinguishes them.
+*/
+
+#define DATA TESTSDIR"tst-caseinsensitive1-data/legacy.ini"
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int retval = 0;
+  char *val;
+  int32_t level;
+  size_t number;
+  char **names;
+
+  if ((error = econf_readFileWithFlags (&key_file, DATA, "=", "#",
+					ECONF_CASE_INSENSITIVE)))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  if ((error = econf_getStringValue (key_file, "global", "WORKGROUP", &val)) ||
+      strcmp (val, "HOME") != 0)
+    {
+      fprintf (stderr, "ERROR: global/WORKGROUP: %s\n",
+	       error ? econf_errString(error) : val);
+      retval = 1;
+    }
+  if (!error)
+    free (val);
+
+  /* The first entry defines the value, also across the spelling */
+  if ((error = econf_getIntValue (key_file, "[GLOBAL]", "LOG_LEVEL", &level)) ||
+      level != 2)
+    {
+      fprintf (stderr, "ERROR: [GLOBAL]/LOG_LEVEL: %s, got %d\n",
+	       econf_errString(error), level);
+      retval = 1;
+    }
+
+  if ((error = econf_getGroups (key_file, &number, &names)) || number != 2 ||
+      strcmp (names[0], "[Global]") != 0 || strcmp (names[1], "[homes]") != 0)
+    {
+      fprintf (stderr, "ERROR: wrong groups: %s, %zu groups\n",
+	       econf_errString(error), error ? 0 : number);
+      retval = 1;
+    }
+  if (!error)
+    econf_free (names);
+
+  if ((error = econf_getKeys (key_file, "global", &number, &names)) ||
+      number != 2)
+    {
+      fprintf (stderr, "ERROR: wrong keys of global: %s, %zu keys\n",
+	       econf_errString(error), error ? 0 : number);
+      retval = 1;
+    }
+  if (!error)
+    econf_free (names);
+
+  /* Setting a value changes the existing entry */
+  econf_setStringValue (key_file, "HOMES", "browseable", "yes");
+  if ((error = econf_getKeys (key_file, "homes", &number, &names)) ||
+      number != 1 || strcmp (names[0], "Browseable") != 0)
+    {
+      fprintf (stderr, "ERROR: wrong keys of homes: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  if (!error)
+    econf_free (names);
+  if ((error = econf_getStringValue (key_file, "homes", "BROWSEABLE", &val)) ||
+      strcmp (val, "yes") != 0)
+    {
+      fprintf (stderr, "ERROR: homes/BROWSEABLE: %s\n",
+	       error ? econf_errString(error) : val);
+      retval = 1;
+    }
+  if (!error)
+    free (val);
+
+  econf_free (key_file);
+
+  /* Without the flag names are case sensitive */
+  if ((error = econf_readFile (&key_file, DATA, "=", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+  if ((error = econf_getStringValue (key_file, "global", "WORKGROUP", &val)) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: case sensitive lookup returned: %s\n",
+	       econf_errString(error));
+      if (!error)
+	free (val);
+      retval = 1;
+    }
+  if ((error = econf_getGroups (key_file, &number, &names)) || number != 3)
+    {
+      fprintf (stderr, "ERROR: case sensitive groups: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  if (!error)
+    econf_free (names);
+  econf_free (key_file);
+
+  return retval;
+}
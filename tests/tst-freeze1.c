@@ -0,0 +1,184 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Freeze a file with many keys and check that every key still has its
+   value, that missing keys, key handles, key lists and prefix queries
+   still work and that the file cannot be modified any more. The keys
+   have to be found by the perfect hash, also for files of other sizes.
+*/
+
+#define KEYS 5000
+
+/* Freeze a file with the keys KEY_0 ... KEY_<n-1> and check that all of
+   them are looked up with the perfect hash */
+static int
+check_perfect (int n)
+{
+  econf_file *key_file = NULL;
+  econf_lookup_stats before, after;
+  char key[32];
+  int32_t ival;
+  int retval = 0;
+
+  if (econf_newKeyFile(&key_file, '=', '#'))
+    return 1;
+  for (int i = 0; i < n; i++)
+    {
+      snprintf (key, sizeof(key), "KEY_%d", i);
+      econf_setIntValue(key_file, NULL, key, i);
+    }
+  econf_countLookups(key_file, true);
+  econf_freeze(key_file);
+  econf_getLookupStats(key_file, &before);
+  for (int i = 0; i < n; i++)
+    {
+      snprintf (key, sizeof(key), "KEY_%d", i);
+      if (econf_getIntValue(key_file, NULL, key, &ival) || ival != i)
+	retval = 1;
+    }
+  econf_getLookupStats(key_file, &after);
+  if (retval || after.perfect - before.perfect != (uint64_t) n)
+    {
+      fprintf (stderr, "ERROR: %d keys: %llu of them found by the perfect hash\n",
+	       n, (unsigned long long) (after.perfect - before.perfect));
+      retval = 1;
+    }
+  econf_free (key_file);
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_keyhandle handle;
+  econf_err error;
+  int retval = 0;
+  char group[32], key[32];
+
+  if ((error = econf_newKeyFile(&key_file, '=', '#')))
+    {
+      fprintf (stderr, "ERROR: couldn't create new file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  for (int i = 0; i < KEYS; i++)
+    {
+      snprintf (group, sizeof(group), "Group%d", i % 37);
+      snprintf (key, sizeof(key), "Key%d", i);
+      econf_setIntValue(key_file, group, key, i);
+    }
+  econf_setStringValue(key_file, NULL, "Name", "frozen");
+  econf_setIntValue(key_file, "Group1", "Key1", -1);
+
+  /* Cached before freezing */
+  int32_t ival;
+  econf_getIntValue(key_file, "Group2", "Key2", &ival);
+  econf_resolveKey(key_file, "Group3", "Key3", &handle);
+  econf_countLookups(key_file, true);
+
+  if ((error = econf_freeze(key_file)) || (error = econf_freeze(key_file)))
+    {
+      fprintf (stderr, "ERROR: couldn't freeze file: %s\n",
+	       econf_errString(error));
+      econf_free (key_file);
+      return 1;
+    }
+
+  econf_lookup_stats before, after;
+  econf_getLookupStats(key_file, &before);
+  for (int i = 0; i < KEYS; i++)
+    {
+      snprintf (group, sizeof(group), "[Group%d]", i % 37);
+      snprintf (key, sizeof(key), "Key%d", i);
+      if ((error = econf_getIntValue(key_file, group, key, &ival)) ||
+	  ival != (i == 1 ? -1 : i))
+	{
+	  fprintf (stderr, "ERROR: %s/%s: %s, got %d\n", group, key,
+		   econf_errString(error), ival);
+	  retval = 1;
+	}
+    }
+
+  econf_getLookupStats(key_file, &after);
+  if (after.perfect - before.perfect != KEYS)
+    {
+      fprintf (stderr, "ERROR: %llu of %d keys found by the perfect hash\n",
+	       (unsigned long long) (after.perfect - before.perfect), KEYS);
+      retval = 1;
+    }
+
+  const char *sval;
+  if ((error = econf_getStringValueRef(key_file, NULL, "Name", &sval)) ||
+      strcmp (sval, "frozen") != 0)
+    {
+      fprintf (stderr, "ERROR: Name: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  if ((error = econf_getIntValue(key_file, "Group1", "Key2", &ival)) != ECONF_NOKEY ||
+      (error = econf_getIntValue(key_file, "Group4", "Missing", &ival)) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: missing key returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  if ((error = econf_getIntValueH(key_file, handle, &ival)) || ival != 3)
+    {
+      fprintf (stderr, "ERROR: handle resolved before freezing: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  char **list;
+  size_t length;
+  if ((error = econf_getGroups(key_file, &length, &list)) || length != 37 ||
+      strcmp (list[0], "[Group0]") != 0)
+    {
+      fprintf (stderr, "ERROR: groups: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  if (!error)
+    econf_freeArray (list);
+  /* The keys of Group1 whose number starts with 1 */
+  if ((error = econf_getKeysPrefix(key_file, "Group1", "Key1", &length, &list)) ||
+      length != 32 || strcmp (list[0], "Key1") != 0)
+    {
+      fprintf (stderr, "ERROR: prefix query: %s, %zu keys\n",
+	       econf_errString(error), length);
+      retval = 1;
+    }
+  if (!error)
+    econf_freeArray (list);
+
+  if ((error = econf_setIntValue(key_file, "Group1", "Key1", 1)) != ECONF_FROZEN ||
+      (error = econf_setStringValue(key_file, "New", "Key", "value")) != ECONF_FROZEN ||
+      (error = econf_countLookups(key_file, false)) != ECONF_FROZEN)
+    {
+      fprintf (stderr, "ERROR: setting a value returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  if (econf_getIntValue(key_file, "Group1", "Key1", &ival) || ival != -1 ||
+      econf_getStringValueRef(key_file, "New", "Key", &sval) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: frozen file has been modified\n");
+      retval = 1;
+    }
+
+  econf_free (key_file);
+
+  static const int sizes[] = {1, 5, 10, 58, 63, 1766, 10000};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    retval |= check_perfect (sizes[i]);
+
+  return retval;
+}
@@ -0,0 +1,118 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Read values of all types, defaults for missing keys and a value which
+   cannot be parsed with a single econf_getBatch() call and check the
+   results and the status of every query.
+*/
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_newKeyFile(&key_file, '=', '#')))
+    {
+      fprintf (stderr, "ERROR: couldn't create new file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  econf_setIntValue(key_file, "Limits", "MaxConn", 42);
+  econf_setInt64Value(key_file, "Limits", "MaxSize", INT64_MAX);
+  econf_setUIntValue(key_file, "Limits", "Workers", 8);
+  econf_setUInt64Value(key_file, "Limits", "MaxBytes", UINT64_MAX);
+  econf_setFloatValue(key_file, "Timeouts", "Idle", 1.5);
+  econf_setDoubleValue(key_file, "Timeouts", "Connect", 2.5);
+  econf_setStringValue(key_file, NULL, "Name", "server");
+  econf_setBoolValue(key_file, NULL, "Enabled", "yes");
+  econf_setStringValue(key_file, NULL, "Broken", "12abc");
+
+  int32_t max_conn = 0, broken = 0, retries = 0;
+  const int32_t def_retries = 3;
+  int64_t max_size = 0;
+  uint32_t workers = 0;
+  uint64_t max_bytes = 0;
+  float idle = 0;
+  double connect = 0;
+  char *name = NULL, *user = NULL;
+  bool enabled = false, debug = true;
+  const bool def_debug = false;
+  econf_err status[12];
+
+  const econf_query queries[] = {
+    {"Limits", "MaxConn", ECONF_TYPE_INT, &max_conn, NULL, &status[0]},
+    {"[Limits]", "MaxSize", ECONF_TYPE_INT64, &max_size, NULL, &status[1]},
+    {"Limits", "Workers", ECONF_TYPE_UINT, &workers, NULL, &status[2]},
+    {"Limits", "MaxBytes", ECONF_TYPE_UINT64, &max_bytes, NULL, &status[3]},
+    {"Timeouts", "Idle", ECONF_TYPE_FLOAT, &idle, NULL, &status[4]},
+    {"Timeouts", "Connect", ECONF_TYPE_DOUBLE, &connect, NULL, &status[5]},
+    {NULL, "Name", ECONF_TYPE_STRING, &name, "default", &status[6]},
+    {"", "Enabled", ECONF_TYPE_BOOL, &enabled, NULL, &status[7]},
+    {"Limits", "Retries", ECONF_TYPE_INT, &retries, &def_retries, &status[8]},
+    {NULL, "User", ECONF_TYPE_STRING, &user, "nobody", &status[9]},
+    {NULL, "Debug", ECONF_TYPE_BOOL, &debug, &def_debug, &status[10]},
+    {NULL, "Broken", ECONF_TYPE_INT, &broken, NULL, &status[11]},
+  };
+  const econf_err expected[] = {
+    ECONF_SUCCESS, ECONF_SUCCESS, ECONF_SUCCESS, ECONF_SUCCESS,
+    ECONF_SUCCESS, ECONF_SUCCESS, ECONF_SUCCESS, ECONF_SUCCESS,
+    ECONF_NOKEY, ECONF_NOKEY, ECONF_NOKEY, ECONF_PARSE_ERROR
+  };
+
+  /* Only the unparsable value is reported, defaults are fine */
+  if ((error = econf_getBatch(key_file, queries, 12)) != ECONF_PARSE_ERROR)
+    {
+      fprintf (stderr, "ERROR: econf_getBatch returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  for (int i = 0; i < 12; i++)
+    if (status[i] != expected[i])
+      {
+	fprintf (stderr, "ERROR: query %d (%s): got '%s', expected '%s'\n",
+		 i, queries[i].key, econf_errString(status[i]),
+		 econf_errString(expected[i]));
+	retval = 1;
+      }
+
+  if (max_conn != 42 || max_size != INT64_MAX || workers != 8 ||
+      max_bytes != UINT64_MAX || idle != 1.5 || connect != 2.5 ||
+      !enabled || retries != 3 || debug || broken != 0)
+    {
+      fprintf (stderr, "ERROR: wrong values returned\n");
+      retval = 1;
+    }
+  if (!name || strcmp(name, "server") != 0 ||
+      !user || strcmp(user, "nobody") != 0)
+    {
+      fprintf (stderr, "ERROR: wrong strings returned: '%s', '%s'\n",
+	       name ? name : "NULL", user ? user : "NULL");
+      retval = 1;
+    }
+  free (name);
+  free (user);
+
+  /* A missing key without default is an error */
+  const econf_query missing = {NULL, "Missing", ECONF_TYPE_INT, &retries, NULL, NULL};
+  if ((error = econf_getBatch(key_file, &missing, 1)) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: missing key returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  econf_free (key_file);
+
+  return retval;
+}
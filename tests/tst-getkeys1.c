@@ -0,0 +1,105 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Read a file with duplicate keys which are not adjacent and with a group
+   which is split into two parts, append a key to an existing group and
+   check that econf_getKeys() returns every key of a group exactly once,
+   in order of its first appearance.
+*/
+
+static int
+check_keys (econf_file *key_file, const char *group, const char *expected[])
+{
+  char **keys;
+  size_t key_number, expected_number = 0;
+  econf_err error;
+  int retval = 0;
+
+  while (expected[expected_number])
+    expected_number++;
+
+  if ((error = econf_getKeys(key_file, group, &key_number, &keys)))
+    {
+      fprintf (stderr, "Error getting keys of group '%s': %s\n",
+	       group ? group : "NULL", econf_errString(error));
+      return 1;
+    }
+  if (key_number != expected_number)
+    {
+      fprintf (stderr, "Group '%s': got %lu keys, expected %lu\n",
+	       group ? group : "NULL", key_number, expected_number);
+      retval = 1;
+    }
+  for (size_t i = 0; i < key_number && i < expected_number; i++)
+    if (strcmp(keys[i], expected[i]) != 0)
+      {
+	fprintf (stderr, "Group '%s': key %lu is '%s', expected '%s'\n",
+		 group ? group : "NULL", i, keys[i], expected[i]);
+	retval = 1;
+      }
+  if (keys[key_number] != NULL)
+    {
+      fprintf (stderr, "Group '%s': key array is not NULL terminated\n",
+	       group ? group : "NULL");
+      retval = 1;
+    }
+  econf_free (keys);
+
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int retval = 0;
+  const char *nogroup[] = {"KEY1", "KEY5", NULL};
+  const char *group1[] = {"KEY1", "KEY2", "KEY3", "KEY4", "KEY6", NULL};
+  const char *group2[] = {"KEY1", NULL};
+
+  if ((error = econf_readFile (&key_file, TESTSDIR"tst-getkeys1-data/getkeys.conf", "=", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n", econf_errString(error));
+      return 1;
+    }
+
+  econf_setStringValue (key_file, "Group1", "KEY6", "appended");
+  econf_setStringValue (key_file, "Group1", "KEY1", "changed");
+  econf_setStringValue (key_file, NULL, "KEY5", "appended");
+
+  retval |= check_keys (key_file, NULL, nogroup);
+  retval |= check_keys (key_file, "Group1", group1);
+  retval |= check_keys (key_file, "[Group1]", group1);
+  retval |= check_keys (key_file, "Group2", group2);
+
+  char **keys;
+  if ((error = econf_getKeys(key_file, "Group3", NULL, &keys)) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "Keys of missing group returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  /* The first entry of a key defines its value */
+  char *val;
+  if ((error = econf_getStringValue (key_file, "Group1", "KEY2", &val)) ||
+      strcmp (val, "value2") != 0)
+    {
+      fprintf (stderr, "Wrong value of KEY2: %s\n", error ? econf_errString(error) : val);
+      retval = 1;
+    }
+  if (!error)
+    free (val);
+
+  econf_free (key_file);
+
+  return retval;
+}
@@ -0,0 +1,141 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Query keys by prefix and by wildcard pattern, before and after adding
+   keys, and check that exactly the matching keys are returned in order of
+   their first appearance.
+*/
+
+static int
+check_keys (const char *test, econf_err error, char **keys, size_t key_number,
+	    const char *expected[])
+{
+  size_t expected_number = 0;
+  int retval = 0;
+
+  while (expected[expected_number])
+    expected_number++;
+
+  if (expected_number == 0)
+    {
+      if (error != ECONF_NOKEY)
+	{
+	  fprintf (stderr, "%s: returned '%s', expected no keys\n", test,
+		   econf_errString(error));
+	  if (!error)
+	    econf_free (keys);
+	  return 1;
+	}
+      return 0;
+    }
+  if (error)
+    {
+      fprintf (stderr, "%s: %s\n", test, econf_errString(error));
+      return 1;
+    }
+  if (key_number != expected_number)
+    {
+      fprintf (stderr, "%s: got %zu keys, expected %zu\n", test,
+	       key_number, expected_number);
+      retval = 1;
+    }
+  for (size_t i = 0; i < key_number && i < expected_number; i++)
+    if (strcmp(keys[i], expected[i]) != 0)
+      {
+	fprintf (stderr, "%s: key %zu is '%s', expected '%s'\n", test, i,
+		 keys[i], expected[i]);
+	retval = 1;
+      }
+  if (keys[key_number] != NULL)
+    {
+      fprintf (stderr, "%s: key array is not NULL terminated\n", test);
+      retval = 1;
+    }
+  econf_free (keys);
+  return retval;
+}
+
+static int
+check_prefix (econf_file *key_file, const char *group, const char *prefix,
+	      const char *expected[])
+{
+  char **keys = NULL;
+  size_t key_number = 0;
+  econf_err error = econf_getKeysPrefix(key_file, group, prefix, &key_number, &keys);
+
+  return check_keys (prefix, error, keys, key_number, expected);
+}
+
+static int
+check_glob (econf_file *key_file, const char *group, const char *pattern,
+	    const char *expected[])
+{
+  char **keys = NULL;
+  size_t key_number = 0;
+  econf_err error = econf_getKeysGlob(key_file, group, pattern, &key_number, &keys);
+
+  return check_keys (pattern, error, keys, key_number, expected);
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int retval = 0;
+  const char *pass[] = {"PASS_MAX_DAYS", "PASS_MIN_DAYS", "PASS_WARN_AGE",
+			"PASS_ALWAYS_WARN", NULL};
+  const char *pass_mw[] = {"PASS_MAX_DAYS", "PASS_MIN_DAYS", "PASS_WARN_AGE", NULL};
+  const char *encrypt[] = {"ENCRYPT_METHOD", "ENCRYPT_METHOD_NIS", NULL};
+  const char *all[] = {"MAIL_DIR", "PASS_MAX_DAYS", "PASS_MIN_DAYS",
+		       "PASS_WARN_AGE", "UID_MIN", "UID_MAX", "ENCRYPT_METHOD",
+		       "SHA_CRYPT_MIN_ROUNDS", "ENCRYPT_METHOD_NIS",
+		       "PASS_ALWAYS_WARN", NULL};
+  const char *min[] = {"PASS_MIN_DAYS", "UID_MIN", "SHA_CRYPT_MIN_ROUNDS", NULL};
+  const char *uid[] = {"UID_MIN", "UID_MAX", NULL};
+  const char *warn[] = {"PASS_WARN_AGE", "PASS_ALWAYS_WARN", NULL};
+  const char *none[] = {NULL};
+  const char *limits[] = {"MAX_CONN", "MAX_SIZE", NULL};
+  const char *limits2[] = {"MAX_CONN", "MAX_SIZE", "MAX_AGE", NULL};
+
+  if ((error = econf_readFile (&key_file, TESTSDIR"tst-getkeys2-data/login.defs", " \t", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n", econf_errString(error));
+      return 1;
+    }
+
+  retval |= check_prefix (key_file, NULL, "PASS_", pass);
+  retval |= check_prefix (key_file, NULL, "ENCRYPT_", encrypt);
+  retval |= check_prefix (key_file, NULL, "ENCRYPT_METHOD_NIS", encrypt + 1);
+  retval |= check_prefix (key_file, NULL, "", all);
+  retval |= check_prefix (key_file, NULL, "pass_", none);
+  retval |= check_prefix (key_file, NULL, "ZZZ", none);
+  retval |= check_prefix (key_file, "Limits", "MAX_", none);
+  retval |= check_glob (key_file, NULL, "*_MIN*", min);
+  retval |= check_glob (key_file, NULL, "UID_M??", uid);
+  retval |= check_glob (key_file, NULL, "*WARN*", warn);
+  retval |= check_glob (key_file, NULL, "PASS_[MW]*", pass_mw);
+  retval |= check_glob (key_file, NULL, "*", all);
+  retval |= check_glob (key_file, NULL, "MAIL", none);
+
+  /* New keys must be found by the next query */
+  econf_setStringValue (key_file, "Limits", "MIN_FREE", "10");
+  econf_setStringValue (key_file, "Limits", "MAX_CONN", "100");
+  econf_setStringValue (key_file, "Limits", "MAX_SIZE", "1G");
+  retval |= check_prefix (key_file, "Limits", "MAX_", limits);
+  econf_setStringValue (key_file, "[Limits]", "MAX_AGE", "7");
+  econf_setStringValue (key_file, "Limits", "MAX_CONN", "200");
+  retval |= check_prefix (key_file, "[Limits]", "MAX_", limits2);
+  retval |= check_glob (key_file, "Limits", "MAX_*", limits2);
+
+  econf_free (key_file);
+
+  return retval;
+}
@@ -0,0 +1,61 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Read a file in which a group is split into two parts, append keys to
+   existing groups and a new one and check that econf_getGroups() lists
+   every group exactly once, in order of its first appearance.
+*/
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  char **groups;
+  size_t group_number;
+  econf_err error;
+  int retval = 0;
+  const char *expected[] = {"[Group1]", "[Group2]", "[Group3]"};
+
+  if ((error = econf_readFile (&key_file, TESTSDIR"tst-getkeys1-data/getkeys.conf", "=", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n", econf_errString(error));
+      return 1;
+    }
+
+  econf_setStringValue (key_file, "Group1", "KEY7", "appended");
+  econf_setStringValue (key_file, "Group3", "KEY1", "new group");
+  econf_setStringValue (key_file, "[Group2]", "KEY2", "appended");
+  econf_setStringValue (key_file, NULL, "KEY2", "no group");
+
+  if ((error = econf_getGroups(key_file, &group_number, &groups)))
+    {
+      fprintf (stderr, "Error getting all groups: %s\n", econf_errString(error));
+      econf_free (key_file);
+      return 1;
+    }
+  if (group_number != 3)
+    {
+      fprintf (stderr, "Wrong number of groups found, got %lu, expected 3\n",
+	       group_number);
+      retval = 1;
+    }
+  for (size_t i = 0; i < group_number && i < 3; i++)
+    if (strcmp(groups[i], expected[i]) != 0)
+      {
+	fprintf (stderr, "Group %lu is '%s', expected '%s'\n",
+		 i, groups[i], expected[i]);
+	retval = 1;
+      }
+
+  econf_free (groups);
+  econf_free (key_file);
+
+  return retval;
+}
@@ -0,0 +1,142 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Read a configuration through a handle and reload it, then let several
+   threads read snapshots while another one publishes new ones and check
+   that every snapshot is consistent and never older than the previous.
+*/
+
+#define READERS 4
+#define GENERATIONS 200
+
+static econf_handle *handle;
+static int done = 0;
+
+static econf_file *
+generation (int32_t gen)
+{
+  econf_file *key_file = NULL;
+
+  if (econf_newKeyFile(&key_file, '=', '#'))
+    return NULL;
+  econf_setIntValue(key_file, "Server", "Generation", gen);
+  econf_setIntValue(key_file, "Server", "Check", -gen);
+  return key_file;
+}
+
+static void *
+reader (void *arg)
+{
+  int32_t last = 0, gen, check;
+  intptr_t errors = 0;
+
+  (void) arg;
+  while (!__atomic_load_n(&done, __ATOMIC_SEQ_CST))
+    {
+      econf_snapshot snap;
+
+      econf_handleAcquire(handle, &snap);
+      if (econf_getIntValue(snap.file, "Server", "Generation", &gen) ||
+	  econf_getIntValue(snap.file, "Server", "Check", &check) ||
+	  check != -gen || gen < last)
+	errors++;
+      last = gen;
+      econf_handleRelease(handle, &snap);
+    }
+  return (void *) errors;
+}
+
+int
+main(void)
+{
+  econf_snapshot snap;
+  econf_err error;
+  int32_t ival;
+  int retval = 0;
+
+  if ((error = econf_newHandle(&handle, TESTSDIR"tst-overlay1-data/usr/etc",
+			       TESTSDIR"tst-overlay1-data/etc", "overlay",
+			       "conf", "=", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't create handle: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  for (int i = 0; i < 2; i++)
+    {
+      econf_handleAcquire(handle, &snap);
+      if ((error = econf_getIntValue(snap.file, "Server", "Port", &ival)) ||
+	  ival != 82)
+	{
+	  fprintf (stderr, "ERROR: Port: %s, got %d\n", econf_errString(error),
+		   ival);
+	  retval = 1;
+	}
+      if ((error = econf_setIntValue(snap.file, "Server", "Port", 1)) != ECONF_FROZEN)
+	{
+	  fprintf (stderr, "ERROR: modifying a snapshot returned: %s\n",
+		   econf_errString(error));
+	  retval = 1;
+	}
+      econf_handleRelease(handle, &snap);
+      if ((error = econf_handleReload(handle)))
+	{
+	  fprintf (stderr, "ERROR: reload failed: %s\n", econf_errString(error));
+	  retval = 1;
+	}
+    }
+
+  if ((error = econf_handlePublish(handle, generation (0))))
+    {
+      fprintf (stderr, "ERROR: publishing failed: %s\n", econf_errString(error));
+      econf_free (handle);
+      return 1;
+    }
+
+  pthread_t threads[READERS];
+  for (int i = 0; i < READERS; i++)
+    pthread_create(&threads[i], NULL, reader, NULL);
+  for (int32_t gen = 1; gen <= GENERATIONS; gen++)
+    if ((error = econf_handlePublish(handle, generation (gen))))
+      {
+	fprintf (stderr, "ERROR: publishing %d failed: %s\n", gen,
+		 econf_errString(error));
+	retval = 1;
+      }
+  __atomic_store_n(&done, 1, __ATOMIC_SEQ_CST);
+  for (int i = 0; i < READERS; i++)
+    {
+      void *errors;
+
+      pthread_join(threads[i], &errors);
+      if (errors)
+	{
+	  fprintf (stderr, "ERROR: reader %d saw %ld inconsistent snapshots\n",
+		   i, (long) (intptr_t) errors);
+	  retval = 1;
+	}
+    }
+
+  econf_handleAcquire(handle, &snap);
+  if (econf_getIntValue(snap.file, "Server", "Generation", &ival) ||
+      ival != GENERATIONS)
+    {
+      fprintf (stderr, "ERROR: last generation is %d\n", ival);
+      retval = 1;
+    }
+  econf_handleRelease(handle, &snap);
+
+  econf_free (handle);
+
+  return retval;
+}
@@ -0,0 +1,114 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Walk over a file with duplicate keys and a group which is split into
+   two parts, in file order and grouped, and check that every key is
+   returned once with its value and line number and that modifying the
+   file stops the iteration.
+*/
+
+struct expected
+{
+  const char *group, *key, *value;
+  uint64_t line_number;
+};
+
+static int
+check_iter (econf_file *key_file, enum econf_iter_order order,
+	    const struct expected *expected, size_t length)
+{
+  econf_iter iter;
+  econf_err error;
+  size_t n = 0;
+  int retval = 0;
+
+  if ((error = econf_iterInit(key_file, order, &iter)))
+    {
+      fprintf (stderr, "ERROR: econf_iterInit: %s\n", econf_errString(error));
+      return 1;
+    }
+  while (!(error = econf_iterNext(&iter)))
+    {
+      if (n >= length)
+	{
+	  fprintf (stderr, "ERROR: order %d: unexpected entry %s\n", order,
+		   iter.key);
+	  return 1;
+	}
+      if ((iter.group == NULL) != (expected[n].group == NULL) ||
+	  (iter.group && strcmp(iter.group, expected[n].group) != 0) ||
+	  strcmp(iter.key, expected[n].key) != 0 ||
+	  strcmp(iter.value, expected[n].value) != 0 ||
+	  iter.line_number != expected[n].line_number)
+	{
+	  fprintf (stderr, "ERROR: order %d, entry %zu: got %s %s=%s line %llu\n",
+		   order, n, iter.group ? iter.group : "NULL", iter.key,
+		   iter.value, (unsigned long long) iter.line_number);
+	  retval = 1;
+	}
+      n++;
+    }
+  if (error != ECONF_NOKEY || n != length)
+    {
+      fprintf (stderr, "ERROR: order %d: %s after %zu entries\n", order,
+	       econf_errString(error), n);
+      retval = 1;
+    }
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int retval = 0;
+  const struct expected file_order[] = {
+    {NULL, "KEY1", "nogroup", 1},
+    {"[Group1]", "KEY1", "value1", 3},
+    {"[Group1]", "KEY2", "value2", 4},
+    {"[Group1]", "KEY3", "value3", 6},
+    {"[Group2]", "KEY1", "value1", 8},
+    {"[Group1]", "KEY4", "value4", 11}
+  };
+  const struct expected grouped[] = {
+    {NULL, "KEY1", "nogroup", 1},
+    {"[Group1]", "KEY1", "value1", 3},
+    {"[Group1]", "KEY2", "value2", 4},
+    {"[Group1]", "KEY3", "value3", 6},
+    {"[Group1]", "KEY4", "value4", 11},
+    {"[Group2]", "KEY1", "value1", 8}
+  };
+
+  if ((error = econf_readFile (&key_file, TESTSDIR"tst-getkeys1-data/getkeys.conf", "=", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n", econf_errString(error));
+      return 1;
+    }
+
+  retval |= check_iter (key_file, ECONF_ITER_FILE_ORDER, file_order, 6);
+  retval |= check_iter (key_file, ECONF_ITER_GROUPED, grouped, 6);
+
+  econf_iter iter;
+  econf_iterInit(key_file, ECONF_ITER_GROUPED, &iter);
+  econf_iterNext(&iter);
+  econf_setStringValue(key_file, "Group2", "KEY2", "new");
+  if ((error = econf_iterNext(&iter)) != ECONF_INVALID_HANDLE)
+    {
+      fprintf (stderr, "ERROR: iterating a modified file returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  econf_free (key_file);
+
+  return retval;
+}
@@ -0,0 +1,113 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Resolve keys to handles, read them through the handles and check that
+   the handles get invalid once the file is modified or if they are used
+   with another file.
+*/
+
+int
+main(void)
+{
+  econf_file *key_file = NULL, *other_file = NULL;
+  econf_keyhandle h_int, h_str, h_bool;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_newKeyFile(&key_file, '=', '#')) ||
+      (error = econf_newKeyFile(&other_file, '=', '#')))
+    {
+      fprintf (stderr, "ERROR: couldn't create new file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  econf_setIntValue(key_file, "Limits", "MaxConn", 42);
+  econf_setStringValue(key_file, "Limits", "Name", "server");
+  econf_setBoolValue(key_file, NULL, "Enabled", "yes");
+  econf_setIntValue(other_file, "Limits", "MaxConn", 1);
+
+  if ((error = econf_resolveKey(key_file, "Limits", "Missing", &h_int)) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: resolving a missing key returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  if ((error = econf_resolveKey(key_file, "[Limits]", "MaxConn", &h_int)) ||
+      (error = econf_resolveKey(key_file, "Limits", "Name", &h_str)) ||
+      (error = econf_resolveKey(key_file, NULL, "Enabled", &h_bool)))
+    {
+      fprintf (stderr, "ERROR: couldn't resolve key: %s\n",
+	       econf_errString(error));
+      econf_free(key_file);
+      econf_free(other_file);
+      return 1;
+    }
+
+  int32_t ival = 0;
+  char *sval = NULL;
+  bool bval = false;
+  for (int i = 0; i < 3; i++)
+    {
+      if ((error = econf_getIntValueH(key_file, h_int, &ival)) || ival != 42)
+	{
+	  fprintf (stderr, "ERROR: MaxConn via handle: %s, got %d\n",
+		   econf_errString(error), ival);
+	  retval = 1;
+	}
+      if ((error = econf_getStringValueH(key_file, h_str, &sval)) ||
+	  strcmp(sval, "server") != 0)
+	{
+	  fprintf (stderr, "ERROR: Name via handle: %s, got '%s'\n",
+		   econf_errString(error), sval ? sval : "NULL");
+	  retval = 1;
+	}
+      free(sval);
+      sval = NULL;
+      if ((error = econf_getBoolValueH(key_file, h_bool, &bval)) || !bval)
+	{
+	  fprintf (stderr, "ERROR: Enabled via handle: %s\n",
+		   econf_errString(error));
+	  retval = 1;
+	}
+    }
+
+  /* A handle of one file is not valid for another one */
+  if ((error = econf_getIntValueH(other_file, h_int, &ival)) != ECONF_INVALID_HANDLE)
+    {
+      fprintf (stderr, "ERROR: handle used with other file returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  /* Modifying the file invalidates all handles */
+  econf_setIntValue(key_file, "Limits", "MaxConn", 43);
+  if ((error = econf_getIntValueH(key_file, h_int, &ival)) != ECONF_INVALID_HANDLE)
+    {
+      fprintf (stderr, "ERROR: outdated handle returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  if ((error = econf_resolveKey(key_file, "Limits", "MaxConn", &h_int)) ||
+      (error = econf_getIntValueH(key_file, h_int, &ival)) || ival != 43)
+    {
+      fprintf (stderr, "ERROR: re-resolved handle: %s, got %d\n",
+	       econf_errString(error), ival);
+      retval = 1;
+    }
+
+  econf_free (key_file);
+  econf_free (other_file);
+
+  return retval;
+}
@@ -0,0 +1,111 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Check that ECONF_KEY_HASH() is a constant expression giving the
+   documented djb2 hash and read values through the econf_get*ValueK()
+   getters from a normal and a case insensitive file.
+*/
+
+/* Must be computed by the compiler */
+static const uint64_t limits_hash = ECONF_KEY_HASH("Limits", "MaxConn");
+static const uint64_t nogroup_hash = ECONF_KEY_HASH("", "Enabled");
+
+static uint64_t
+djb2 (const char *group, const char *key)
+{
+  uint64_t hash = 5381;
+
+  for (const char *c = group; *c; c++)
+    hash = hash * 33 + (unsigned char) *c;
+  hash = hash * 33;
+  for (const char *c = key; *c; c++)
+    hash = hash * 33 + (unsigned char) *c;
+  return hash;
+}
+
+static int
+check_getters (econf_file *key_file, const char *name)
+{
+  econf_err error;
+  int32_t ival = 0;
+  bool bval = false;
+  char *sval = NULL;
+  int retval = 0;
+
+  if ((error = econf_getIntValueK(key_file, ECONF_KEY("Limits", "MaxConn"), &ival)) ||
+      ival != 42)
+    {
+      fprintf (stderr, "ERROR: %s: MaxConn: %s, got %d\n", name,
+	       econf_errString(error), ival);
+      retval = 1;
+    }
+  if ((error = econf_getBoolValueK(key_file, ECONF_KEY("", "Enabled"), &bval)) ||
+      !bval)
+    {
+      fprintf (stderr, "ERROR: %s: Enabled: %s\n", name, econf_errString(error));
+      retval = 1;
+    }
+  if ((error = econf_getStringValueK(key_file, ECONF_KEY("Limits", "Name"), &sval)) ||
+      strcmp (sval, "server") != 0)
+    {
+      fprintf (stderr, "ERROR: %s: Name: %s\n", name, econf_errString(error));
+      retval = 1;
+    }
+  free (sval);
+  if ((error = econf_getIntValueK(key_file, ECONF_KEY("Limits", "MaxIdle"), &ival)) != ECONF_NOKEY ||
+      (error = econf_getIntValueK(key_file, ECONF_KEY("", "MaxConn"), &ival)) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: %s: missing key returned: %s\n", name,
+	       econf_errString(error));
+      retval = 1;
+    }
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int retval = 0;
+
+  if (limits_hash != djb2 ("Limits", "MaxConn") ||
+      nogroup_hash != djb2 ("", "Enabled") ||
+      ECONF_KEY("Limits", "MaxConn").hash != limits_hash)
+    {
+      fprintf (stderr, "ERROR: ECONF_KEY_HASH differs from djb2\n");
+      retval = 1;
+    }
+
+  if ((error = econf_newKeyFile(&key_file, '=', '#')))
+    {
+      fprintf (stderr, "ERROR: couldn't create new file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+  econf_setIntValue(key_file, "Limits", "MaxConn", 42);
+  econf_setStringValue(key_file, "[Limits]", "Name", "server");
+  econf_setBoolValue(key_file, NULL, "Enabled", "yes");
+  retval |= check_getters (key_file, "new file");
+  econf_free (key_file);
+
+  if ((error = econf_readFileWithFlags(&key_file, TESTSDIR"tst-keyhash1-data/limits.conf",
+				       "=", "#", ECONF_CASE_INSENSITIVE)))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+  retval |= check_getters (key_file, "case insensitive file");
+  econf_free (key_file);
+
+  return retval;
+}
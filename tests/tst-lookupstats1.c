@@ -0,0 +1,104 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Look up existing and missing keys and check the lookup counters. Most
+   of the missing keys have to be rejected by the membership filter.
+   Nothing is counted before econf_countLookups().
+*/
+
+#define KEYS 1000
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_lookup_stats stats;
+  econf_err error;
+  int retval = 0;
+  char key[32];
+  int32_t value;
+
+  if ((error = econf_newKeyFile(&key_file, '=', '#')))
+    {
+      fprintf (stderr, "ERROR: couldn't create new file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  /* A new file has not been searched yet */
+  if ((error = econf_getLookupStats(key_file, &stats)) ||
+      stats.hits || stats.filtered || stats.misses)
+    {
+      fprintf (stderr, "ERROR: new file has lookups: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  for (int n = 0; n < KEYS; n++)
+    {
+      snprintf (key, sizeof(key), "Option%d", n);
+      econf_setIntValue(key_file, "Limits", key, n);
+    }
+  if ((error = econf_getLookupStats(key_file, &stats)) ||
+      stats.hits || stats.filtered || stats.misses)
+    {
+      fprintf (stderr, "ERROR: lookups counted without econf_countLookups(): %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  if ((error = econf_countLookups(key_file, true)) ||
+      (error = econf_getLookupStats(key_file, &stats)))
+    {
+      fprintf (stderr, "ERROR: couldn't get lookup stats: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+  econf_lookup_stats before = stats;
+
+  for (int n = 0; n < KEYS; n++)
+    {
+      snprintf (key, sizeof(key), "Option%d", n);
+      if ((error = econf_getIntValue(key_file, "Limits", key, &value)) ||
+	  value != n)
+	{
+	  fprintf (stderr, "ERROR: %s: %s\n", key, econf_errString(error));
+	  retval = 1;
+	}
+      snprintf (key, sizeof(key), "Missing%d", n);
+      if ((error = econf_getIntValueDef(key_file, "Limits", key, &value, -1)) != ECONF_NOKEY ||
+	  value != -1)
+	{
+	  fprintf (stderr, "ERROR: %s: %s\n", key, econf_errString(error));
+	  retval = 1;
+	}
+    }
+
+  econf_getLookupStats(key_file, &stats);
+  if (stats.hits - before.hits != KEYS ||
+      stats.filtered + stats.misses - before.filtered - before.misses != KEYS)
+    {
+      fprintf (stderr, "ERROR: wrong counters: %llu hits, %llu filtered, %llu misses\n",
+	       (unsigned long long) (stats.hits - before.hits),
+	       (unsigned long long) (stats.filtered - before.filtered),
+	       (unsigned long long) (stats.misses - before.misses));
+      retval = 1;
+    }
+  if (stats.misses - before.misses > KEYS / 10)
+    {
+      fprintf (stderr, "ERROR: filter rejected only %llu of %d missing keys\n",
+	       (unsigned long long) (stats.filtered - before.filtered), KEYS);
+      retval = 1;
+    }
+
+  econf_free (key_file);
+
+  return retval;
+}
@@ -0,0 +1,112 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   econf_readDirs() merges all files at once. Check that the result has
+   the same entries in the same order as merging the files one by one
+   with econf_mergeFiles(), for files with duplicate keys, keys without
+   group appearing only in a drop-in and new groups.
+*/
+
+static const char *files[] = {
+  TESTSDIR"tst-merge6-data/usr/etc/merge.conf",
+  TESTSDIR"tst-merge6-data/usr/etc/merge.conf.d/10-client.conf",
+  TESTSDIR"tst-merge6-data/etc/merge.conf.d/20-server.conf",
+  TESTSDIR"tst-merge6-data/etc/merge.conf.d/30-new.conf"
+};
+
+static int
+compare (econf_file *merged, econf_file *pairwise, enum econf_iter_order order)
+{
+  econf_iter a, b;
+  econf_err ea, eb;
+  int retval = 0;
+
+  econf_iterInit(merged, order, &a);
+  econf_iterInit(pairwise, order, &b);
+  while (!(ea = econf_iterNext(&a)) & !(eb = econf_iterNext(&b)))
+    {
+      if ((a.group == NULL) != (b.group == NULL) ||
+	  (a.group && strcmp(a.group, b.group) != 0) ||
+	  strcmp(a.key, b.key) != 0 || strcmp(a.value, b.value) != 0)
+	{
+	  fprintf (stderr, "ERROR: order %d: got %s %s=%s, expected %s %s=%s\n",
+		   order, a.group ? a.group : "NULL", a.key, a.value,
+		   b.group ? b.group : "NULL", b.key, b.value);
+	  retval = 1;
+	}
+    }
+  if (ea != ECONF_NOKEY || eb != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: order %d: different number of keys\n", order);
+      retval = 1;
+    }
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_file *merged = NULL, *pairwise = NULL, *key_file, *tmp;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_readDirs(&merged, TESTSDIR"tst-merge6-data/usr/etc",
+			      TESTSDIR"tst-merge6-data/etc", "merge", "conf",
+			      "=", "#")))
+    {
+      fprintf (stderr, "ERROR: econf_readDirs: %s\n", econf_errString(error));
+      return 1;
+    }
+
+  for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+    {
+      if ((error = econf_readFile(&key_file, files[i], "=", "#")))
+	{
+	  fprintf (stderr, "ERROR: couldn't read %s: %s\n", files[i],
+		   econf_errString(error));
+	  econf_free (merged);
+	  econf_free (pairwise);
+	  return 1;
+	}
+      if (pairwise == NULL)
+	{
+	  pairwise = key_file;
+	  continue;
+	}
+      tmp = pairwise;
+      error = econf_mergeFiles(&pairwise, tmp, key_file);
+      econf_free (tmp);
+      econf_free (key_file);
+      if (error)
+	{
+	  fprintf (stderr, "ERROR: econf_mergeFiles: %s\n", econf_errString(error));
+	  econf_free (merged);
+	  return 1;
+	}
+    }
+
+  retval |= compare (merged, pairwise, ECONF_ITER_FILE_ORDER);
+  retval |= compare (merged, pairwise, ECONF_ITER_GROUPED);
+
+  char *val;
+  if ((error = econf_getStringValue(merged, "Server", "Port", &val)) ||
+      strcmp (val, "82") != 0)
+    {
+      fprintf (stderr, "ERROR: Port: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  else
+    free (val);
+
+  econf_free (merged);
+  econf_free (pairwise);
+
+  return retval;
+}
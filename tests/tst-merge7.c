@@ -0,0 +1,231 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Fold the files of tst-merge6 into the first one with
+   econf_mergeFilesInto(), one of them frozen, and check that the result
+   equals merging them one by one with econf_mergeFiles(), that it can
+   still be modified and that a frozen destination is refused.
+   The destination keeps its ECONF_CASE_INSENSITIVE flag and its lookup
+   counters, files with another flag are refused and the destination
+   can't be refreshed any more.
+*/
+
+static const char *files[] = {
+  TESTSDIR"tst-merge6-data/usr/etc/merge.conf",
+  TESTSDIR"tst-merge6-data/usr/etc/merge.conf.d/10-client.conf",
+  TESTSDIR"tst-merge6-data/etc/merge.conf.d/20-server.conf",
+  TESTSDIR"tst-merge6-data/etc/merge.conf.d/30-new.conf"
+};
+
+static int
+compare (econf_file *merged, econf_file *pairwise, enum econf_iter_order order)
+{
+  econf_iter a, b;
+  econf_err ea, eb;
+  int retval = 0;
+
+  econf_iterInit(merged, order, &a);
+  econf_iterInit(pairwise, order, &b);
+  while (!(ea = econf_iterNext(&a)) & !(eb = econf_iterNext(&b)))
+    {
+      if ((a.group == NULL) != (b.group == NULL) ||
+	  (a.group && strcmp(a.group, b.group) != 0) ||
+	  strcmp(a.key, b.key) != 0 || strcmp(a.value, b.value) != 0)
+	{
+	  fprintf (stderr, "ERROR: order %d: got %s %s=%s, expected %s %s=%s\n",
+		   order, a.group ? a.group : "NULL", a.key, a.value,
+		   b.group ? b.group : "NULL", b.key, b.value);
+	  retval = 1;
+	}
+    }
+  if (ea != ECONF_NOKEY || eb != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: order %d: different number of keys\n", order);
+      retval = 1;
+    }
+  return retval;
+}
+
+/* Merge names in other case into a case insensitive file */
+static int
+check_flags (void)
+{
+  econf_file *dst = NULL, *src = NULL;
+  econf_lookup_stats stats;
+  int32_t val;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_readFileWithFlags(&dst, files[0], "=", "#",
+				       ECONF_CASE_INSENSITIVE)) ||
+      (error = econf_readFile(&src, TESTSDIR"tst-merge7-data/upper.conf",
+			      "=", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't read files: %s\n",
+	       econf_errString(error));
+      econf_free (dst);
+      return 1;
+    }
+  if ((error = econf_mergeFilesInto(dst, src)) != ECONF_ERROR)
+    {
+      fprintf (stderr, "ERROR: merging files with other flags returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  econf_free (src);
+  src = NULL;
+
+  econf_countLookups(dst, true);
+  econf_getIntValue(dst, "Server", "Port", &val);
+  if ((error = econf_readFileWithFlags(&src,
+				       TESTSDIR"tst-merge7-data/upper.conf",
+				       "=", "#", ECONF_CASE_INSENSITIVE)) ||
+      (error = econf_mergeFilesInto(dst, src)))
+    {
+      fprintf (stderr, "ERROR: merging case insensitive files: %s\n",
+	       econf_errString(error));
+      econf_free (dst);
+      return 1;
+    }
+  if (econf_getIntValue(dst, "server", "PORT", &val) || val != 90 ||
+      econf_getIntValue(dst, "Client", "Timeout", &val) || val != 7)
+    {
+      fprintf (stderr, "ERROR: names were not matched ignoring case\n");
+      retval = 1;
+    }
+  econf_getLookupStats(dst, &stats);
+  if (stats.hits != 3)
+    {
+      fprintf (stderr, "ERROR: %llu hits counted, expected 3\n",
+	       (unsigned long long) stats.hits);
+      retval = 1;
+    }
+  econf_free (dst);
+
+  /* The drop-ins read by econf_readDirsWithFlags() are gone */
+  dst = src = NULL;
+  if ((error = econf_readDirsWithFlags(&dst,
+				       TESTSDIR"tst-merge6-data/usr/etc",
+				       TESTSDIR"tst-merge6-data/etc",
+				       "merge", "conf", "=", "#",
+				       ECONF_REFRESHABLE)) ||
+      (error = econf_readFile(&src, TESTSDIR"tst-merge7-data/upper.conf",
+			      "=", "#")) ||
+      (error = econf_mergeFilesInto(dst, src)) ||
+      (error = econf_refresh(dst)) != ECONF_ERROR)
+    {
+      fprintf (stderr, "ERROR: refreshing a merged file returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  econf_free (dst);
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_file *into = NULL, *pairwise = NULL, *key_file, *other, *tmp;
+  econf_err error;
+  int retval = 0;
+
+  for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+    {
+      key_file = other = NULL;
+      if ((error = econf_readFile(&key_file, files[i], "=", "#")) ||
+	  (error = econf_readFile(&other, files[i], "=", "#")))
+	{
+	  fprintf (stderr, "ERROR: couldn't read %s: %s\n", files[i],
+		   econf_errString(error));
+	  econf_free (key_file);
+	  econf_free (into);
+	  econf_free (pairwise);
+	  return 1;
+	}
+      if (into == NULL)
+	{
+	  into = key_file;
+	  pairwise = other;
+	  continue;
+	}
+
+      /* The strings of a frozen file can't be moved, they are copied */
+      if (i == 2 && (error = econf_freeze(key_file)))
+	{
+	  fprintf (stderr, "ERROR: econf_freeze: %s\n", econf_errString(error));
+	  retval = 1;
+	}
+      tmp = into;
+      if ((error = econf_mergeFilesInto(into, key_file)) || into != tmp)
+	{
+	  fprintf (stderr, "ERROR: econf_mergeFilesInto: %s\n",
+		   econf_errString(error));
+	  econf_free (other);
+	  econf_free (into);
+	  econf_free (pairwise);
+	  return 1;
+	}
+
+      tmp = pairwise;
+      error = econf_mergeFiles(&pairwise, tmp, other);
+      econf_free (tmp);
+      econf_free (other);
+      if (error)
+	{
+	  fprintf (stderr, "ERROR: econf_mergeFiles: %s\n", econf_errString(error));
+	  econf_free (into);
+	  return 1;
+	}
+    }
+
+  retval |= compare (into, pairwise, ECONF_ITER_FILE_ORDER);
+  retval |= compare (into, pairwise, ECONF_ITER_GROUPED);
+
+  /* The result is an ordinary file */
+  char *val;
+  if ((error = econf_setStringValue(into, "Server", "Port", "83")) ||
+      (error = econf_getStringValue(into, "Server", "Port", &val)))
+    {
+      fprintf (stderr, "ERROR: changing Port: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  else
+    {
+      if (strcmp (val, "83") != 0)
+	{
+	  fprintf (stderr, "ERROR: Port is %s, expected 83\n", val);
+	  retval = 1;
+	}
+      free (val);
+    }
+
+  if ((error = econf_mergeFilesInto(into, into)) != ECONF_ERROR ||
+      (error = econf_mergeFilesInto(NULL, pairwise)) != ECONF_ERROR)
+    {
+      fprintf (stderr, "ERROR: invalid arguments returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  /* A frozen destination is refused, src stays untouched */
+  econf_freeze(into);
+  if ((error = econf_mergeFilesInto(into, pairwise)) != ECONF_FROZEN)
+    {
+      fprintf (stderr, "ERROR: merging into frozen file returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  econf_free (into);
+  econf_free (pairwise);
+
+  retval |= check_flags ();
+  return retval;
+}
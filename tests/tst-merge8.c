@@ -0,0 +1,79 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   econf_mergeFiles() shares the strings of its input files instead of
+   copying them. Check that the merged file returns the very same strings,
+   that changing a value in one file doesn't change it in the other one
+   and that the merged file stays valid when the inputs are freed.
+*/
+
+static int
+check_value (econf_file *key_file, const char *name, const char *group,
+	     const char *key, const char *expected)
+{
+  const char *val;
+  econf_err error;
+
+  if ((error = econf_getStringValueRef(key_file, group, key, &val)) ||
+      strcmp(val, expected) != 0)
+    {
+      fprintf (stderr, "ERROR: %s: %s/%s: %s, expected '%s'\n", name, group,
+	       key, error ? econf_errString(error) : val, expected);
+      return 1;
+    }
+  return 0;
+}
+
+int
+main(void)
+{
+  econf_file *usr_file = NULL, *etc_file = NULL, *merged = NULL;
+  const char *usr_val, *merged_val;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_readFile(&usr_file, TESTSDIR"tst-merge6-data/usr/etc/merge.conf", "=", "#")) ||
+      (error = econf_readFile(&etc_file, TESTSDIR"tst-merge6-data/etc/merge.conf.d/20-server.conf", "=", "#")) ||
+      (error = econf_mergeFiles(&merged, usr_file, etc_file)))
+    {
+      fprintf (stderr, "ERROR: couldn't merge the files: %s\n",
+	       econf_errString(error));
+      econf_free (usr_file);
+      econf_free (etc_file);
+      return 1;
+    }
+
+  /* Host is only set by usr_file, the merged file holds the same string */
+  if (econf_getStringValueRef(usr_file, "Server", "Host", &usr_val) ||
+      econf_getStringValueRef(merged, "Server", "Host", &merged_val) ||
+      usr_val != merged_val)
+    {
+      fprintf (stderr, "ERROR: the value of Host was copied\n");
+      retval = 1;
+    }
+
+  /* Changing a value affects only the file it is set in */
+  econf_setStringValue(merged, "Server", "Host", "merged");
+  econf_setStringValue(usr_file, "Client", "Retries", "3");
+  retval |= check_value (usr_file, "usr", "Server", "Host", "vendor");
+  retval |= check_value (merged, "merged", "Server", "Host", "merged");
+  retval |= check_value (merged, "merged", "Client", "Retries", "1");
+
+  econf_free (usr_file);
+  econf_free (etc_file);
+
+  retval |= check_value (merged, "merged", "Server", "Port", "82");
+  retval |= check_value (merged, "merged", "Log", "Level", "debug");
+  retval |= check_value (merged, "merged", "", "Name", "etc");
+
+  econf_free (merged);
+
+  return retval;
+}
@@ -0,0 +1,59 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Duplicate keys in drop-ins. The last duplicate overrides a key merged
+   before, also one in the second part of a group split in two. A key new
+   in a file gets its first value, also in a group new in that file.
+*/
+
+static const struct {
+  const char *group, *key, *value;
+} expected[] = {
+  {"One", "A", "usr"},
+  {"One", "B", "last"},
+  {"One", "C", "etc-last"},
+  {"One", "D", "first"},
+  {"Two", "K", "usr"},
+  {"New", "N", "first"}
+};
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_readDirs(&key_file, TESTSDIR"tst-merge9-data/usr/etc",
+			      TESTSDIR"tst-merge9-data/etc", "dup", "conf",
+			      "=", "#")))
+    {
+      fprintf (stderr, "ERROR: econf_readDirs: %s\n", econf_errString(error));
+      return 1;
+    }
+
+  for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+      const char *val;
+      if ((error = econf_getStringValueRef(key_file, expected[i].group,
+					   expected[i].key, &val)) ||
+	  strcmp (val, expected[i].value) != 0)
+	{
+	  fprintf (stderr, "ERROR: %s/%s: %s, expected '%s'\n",
+		   expected[i].group, expected[i].key,
+		   error ? econf_errString(error) : val, expected[i].value);
+	  retval = 1;
+	}
+    }
+
+  econf_free (key_file);
+
+  return retval;
+}
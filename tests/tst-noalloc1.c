@@ -0,0 +1,189 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Looking up existing keys with the typed getters and the borrowing string
+   getters must not allocate any memory, regardless of how the group is
+   written, and reading a boolean must not modify the stored value.
+   malloc, calloc and realloc are interposed to count the
+   allocations done by the library.
+*/
+
+#ifdef __SANITIZE_ADDRESS__
+int
+main(void)
+{
+  /* ASan brings its own allocator, interposing it is not possible */
+  return 77;
+}
+#else
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static bool counting = false;
+static size_t allocations = 0;
+
+void *
+malloc(size_t size)
+{
+  if (counting)
+    allocations++;
+  return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+  if (counting)
+    allocations++;
+  return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+  if (counting)
+    allocations++;
+  return __libc_realloc(ptr, size);
+}
+
+static int
+check_getters (econf_file *key_file, const char *group)
+{
+  int32_t i32;
+  int64_t i64;
+  uint32_t u32;
+  uint64_t u64;
+  float f;
+  double d;
+  bool b;
+  const char *value;
+  econf_iter iter;
+  size_t length, key_number = 0;
+  econf_err error = ECONF_SUCCESS;
+
+  allocations = 0;
+  counting = true;
+  error |= econf_getIntValue(key_file, group, "Int", &i32);
+  error |= econf_getInt64Value(key_file, group, "Int64", &i64);
+  error |= econf_getUIntValue(key_file, group, "UInt", &u32);
+  error |= econf_getUInt64Value(key_file, group, "UInt64", &u64);
+  error |= econf_getFloatValue(key_file, group, "Float", &f);
+  error |= econf_getDoubleValue(key_file, group, "Double", &d);
+  error |= econf_getBoolValue(key_file, group, "Bool", &b);
+  error |= econf_getStringValueRef(key_file, group, "String", &value);
+  error |= econf_getStringValueRefLen(key_file, group, "String", &value, &length);
+  error |= econf_iterInit(key_file, ECONF_ITER_GROUPED, &iter);
+  while (!econf_iterNext(&iter))
+    key_number++;
+  counting = false;
+
+  if (error)
+    {
+      fprintf (stderr, "ERROR: getting values from group '%s' failed\n",
+	       group ? group : "NULL");
+      return 1;
+    }
+  if (!b)
+    {
+      fprintf (stderr, "ERROR: group '%s': Bool is false\n",
+	       group ? group : "NULL");
+      return 1;
+    }
+  if (econf_getStringValueRef(key_file, group, "Bool", &value) ||
+      strcmp(value, "YES") != 0)
+    {
+      fprintf (stderr, "ERROR: group '%s': stored bool value changed to '%s'\n",
+	       group ? group : "NULL", value);
+      return 1;
+    }
+  if (key_number != 16)
+    {
+      fprintf (stderr, "ERROR: group '%s': iterated over %zu keys\n",
+	       group ? group : "NULL", key_number);
+      return 1;
+    }
+  if (allocations)
+    {
+      fprintf (stderr, "ERROR: group '%s': %zu allocations on lookup\n",
+	       group ? group : "NULL", allocations);
+      return 1;
+    }
+  return 0;
+}
+
+static int
+fill_group (econf_file *key_file, const char *group)
+{
+  econf_err error = ECONF_SUCCESS;
+
+  error |= econf_setIntValue(key_file, group, "Int", INT32_MIN);
+  error |= econf_setInt64Value(key_file, group, "Int64", INT64_MAX);
+  error |= econf_setUIntValue(key_file, group, "UInt", UINT32_MAX);
+  error |= econf_setUInt64Value(key_file, group, "UInt64", UINT64_MAX);
+  error |= econf_setFloatValue(key_file, group, "Float", 1.5);
+  error |= econf_setDoubleValue(key_file, group, "Double", 2.5);
+  error |= econf_setStringValue(key_file, group, "String", "borrowed");
+  error |= econf_setStringValue(key_file, group, "Bool", "YES");
+
+  if (error)
+    {
+      fprintf (stderr, "ERROR: couldn't set values in group '%s'\n",
+	       group ? group : "NULL");
+      return 1;
+    }
+  return 0;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_newKeyFile(&key_file, '=', '#')))
+    {
+      fprintf (stderr, "ERROR: couldn't create new file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  if (fill_group (key_file, NULL) || fill_group (key_file, "Group"))
+    {
+      econf_free (key_file);
+      return 1;
+    }
+
+  retval |= check_getters (key_file, NULL);
+  retval |= check_getters (key_file, "");
+  retval |= check_getters (key_file, "Group");
+  retval |= check_getters (key_file, "[Group]");
+
+  /* A missing key must not allocate either */
+  int32_t dummy;
+  allocations = 0;
+  counting = true;
+  error = econf_getIntValue(key_file, "Group", "Missing", &dummy);
+  counting = false;
+  if (error != ECONF_NOKEY || allocations)
+    {
+      fprintf (stderr, "ERROR: missing key: %s, %zu allocations\n",
+	       econf_errString(error), allocations);
+      retval = 1;
+    }
+
+  econf_free (key_file);
+
+  return retval;
+}
+#endif
@@ -0,0 +1,124 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Read layers with duplicate keys in an overlay and check that every key
+   of every layer has the value econf_readDirs() gives it, then replace a
+   layer and check that the new one is used.
+*/
+
+static int
+compare_layer (econf_overlay *ov, econf_file *merged, econf_file *layer)
+{
+  econf_iter iter;
+  econf_err error;
+  const char *expected, *value;
+  int retval = 0;
+
+  econf_iterInit(layer, ECONF_ITER_FILE_ORDER, &iter);
+  while (!econf_iterNext(&iter))
+    {
+      if ((error = econf_getStringValueRef(merged, iter.group, iter.key, &expected)) ||
+	  (error = econf_overlayGetStringValueRef(ov, iter.group, iter.key, &value)))
+	{
+	  fprintf (stderr, "ERROR: %s/%s: %s\n", iter.group ? iter.group : "NULL",
+		   iter.key, econf_errString(error));
+	  retval = 1;
+	}
+      else if (strcmp (expected, value) != 0)
+	{
+	  fprintf (stderr, "ERROR: %s/%s: got '%s', merged file has '%s'\n",
+		   iter.group ? iter.group : "NULL", iter.key, value, expected);
+	  retval = 1;
+	}
+    }
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_overlay *ov = NULL;
+  econf_file *merged = NULL, *layer = NULL;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_readDirs(&merged, TESTSDIR"tst-overlay1-data/usr/etc",
+			      TESTSDIR"tst-overlay1-data/etc", "overlay", "conf",
+			      "=", "#")) ||
+      (error = econf_readDirsOverlay(&ov, TESTSDIR"tst-overlay1-data/usr/etc",
+				     TESTSDIR"tst-overlay1-data/etc", "overlay",
+				     "conf", "=", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration: %s\n",
+	       econf_errString(error));
+      econf_free (merged);
+      return 1;
+    }
+
+  const char *files[] = {
+    TESTSDIR"tst-overlay1-data/usr/etc/overlay.conf",
+    TESTSDIR"tst-overlay1-data/usr/etc/overlay.conf.d/10-dups.conf",
+    TESTSDIR"tst-overlay1-data/etc/overlay.conf.d/20-etc.conf"
+  };
+  size_t length;
+  if (econf_overlayLength(ov, &length) || length != 3)
+    {
+      fprintf (stderr, "ERROR: overlay has %zu layers, expected 3\n", length);
+      retval = 1;
+    }
+  for (size_t i = 0; i < 3; i++)
+    {
+      if ((error = econf_readFile(&layer, files[i], "=", "#")))
+	{
+	  fprintf (stderr, "ERROR: couldn't read %s: %s\n", files[i],
+		   econf_errString(error));
+	  retval = 1;
+	  continue;
+	}
+      retval |= compare_layer (ov, merged, layer);
+      econf_free (layer);
+    }
+
+  int32_t ival;
+  char *sval = NULL;
+  if ((error = econf_overlayGetIntValue(ov, "Server", "Port", &ival)) || ival != 82 ||
+      (error = econf_overlayGetStringValue(ov, "[New]", "Key", &sval)) ||
+      strcmp (sval, "first") != 0)
+    {
+      fprintf (stderr, "ERROR: Port/Key: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  free (sval);
+  if ((error = econf_overlayGetIntValue(ov, "Server", "Missing", &ival)) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: missing key returned: %s\n", econf_errString(error));
+      retval = 1;
+    }
+
+  /* Replace the drop-in of /etc */
+  econf_newKeyFile(&layer, '=', '#');
+  econf_setIntValue(layer, "Server", "Timeout", 30);
+  if ((error = econf_overlaySetLayer(ov, 2, layer)) ||
+      (error = econf_overlayGetIntValue(ov, "Server", "Timeout", &ival)) ||
+      ival != 30 ||
+      (error = econf_overlayGetStringValueRef(ov, "Server", "Log", (const char **) &sval)) ||
+      strcmp (sval, "a") != 0)
+    {
+      fprintf (stderr, "ERROR: after replacing a layer: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  econf_free (ov);
+  econf_free (merged);
+
+  return retval;
+}
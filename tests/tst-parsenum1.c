@@ -0,0 +1,127 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <locale.h>
+#include <math.h>
+#include <inttypes.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Store strings and read them with the numeric getters. Junk and values
+   out of range must be rejected with ECONF_PARSE_ERROR, and the result
+   must not depend on the current locale.
+*/
+
+static econf_file *key_file;
+
+#define check_type(TYPE, FCT_TYPE, PR)		 \
+static int check_ ## FCT_TYPE (const char *string, econf_err expected_error, \
+			       TYPE expected) \
+{ \
+  TYPE value = 0; \
+  econf_err error; \
+\
+  econf_setStringValue(key_file, NULL, "KEY", string); \
+  error = econf_get ## FCT_TYPE ## Value(key_file, NULL, "KEY", &value); \
+  if (error != expected_error || (!error && value != expected)) \
+    { \
+      fprintf (stderr, "ERROR: " #FCT_TYPE " '%s': got '%" PR "' (%s), expected '%" PR "' (%s)\n", \
+	       string, value, econf_errString(error), expected, \
+	       econf_errString(expected_error)); \
+      return 1; \
+    } \
+  return 0; \
+}
+
+check_type(int32_t, Int, PRId32)
+check_type(int64_t, Int64, PRId64)
+check_type(uint32_t, UInt, PRIu32)
+check_type(uint64_t, UInt64, PRIu64)
+check_type(float, Float, "g")
+check_type(double, Double, "g")
+
+static int
+check_all (void)
+{
+  int retval = 0;
+
+  retval |= check_Int ("42", ECONF_SUCCESS, 42);
+  retval |= check_Int (" -42\t", ECONF_SUCCESS, -42);
+  retval |= check_Int ("+7", ECONF_SUCCESS, 7);
+  retval |= check_Int ("2147483647", ECONF_SUCCESS, INT32_MAX);
+  retval |= check_Int ("-2147483648", ECONF_SUCCESS, INT32_MIN);
+  retval |= check_Int ("2147483648", ECONF_PARSE_ERROR, 0);
+  retval |= check_Int ("-2147483649", ECONF_PARSE_ERROR, 0);
+  retval |= check_Int ("99999999999", ECONF_PARSE_ERROR, 0);
+  retval |= check_Int ("12abc", ECONF_PARSE_ERROR, 0);
+  retval |= check_Int ("0x10", ECONF_PARSE_ERROR, 0);
+  retval |= check_Int ("1 2", ECONF_PARSE_ERROR, 0);
+  retval |= check_Int ("-", ECONF_PARSE_ERROR, 0);
+  retval |= check_Int ("", ECONF_EMPTYKEY, 0);
+
+  retval |= check_Int64 ("9223372036854775807", ECONF_SUCCESS, INT64_MAX);
+  retval |= check_Int64 ("-9223372036854775808", ECONF_SUCCESS, INT64_MIN);
+  retval |= check_Int64 ("9223372036854775808", ECONF_PARSE_ERROR, 0);
+  retval |= check_Int64 ("-9223372036854775809", ECONF_PARSE_ERROR, 0);
+  retval |= check_Int64 ("000000000000000000000000001", ECONF_SUCCESS, 1);
+
+  retval |= check_UInt ("4294967295", ECONF_SUCCESS, UINT32_MAX);
+  retval |= check_UInt ("4294967296", ECONF_PARSE_ERROR, 0);
+  retval |= check_UInt ("-1", ECONF_PARSE_ERROR, 0);
+
+  retval |= check_UInt64 ("18446744073709551615", ECONF_SUCCESS, UINT64_MAX);
+  retval |= check_UInt64 ("18446744073709551616", ECONF_PARSE_ERROR, 0);
+  retval |= check_UInt64 ("184467440737095516150", ECONF_PARSE_ERROR, 0);
+
+  retval |= check_Float ("1.5", ECONF_SUCCESS, 1.5);
+  retval |= check_Float ("-0.1", ECONF_SUCCESS, -0.1f);
+  retval |= check_Float ("3.40282347e+38", ECONF_SUCCESS, 3.40282347e+38f);
+  retval |= check_Float ("1e39", ECONF_PARSE_ERROR, 0);
+  retval |= check_Float ("1,5", ECONF_PARSE_ERROR, 0);
+
+  retval |= check_Double ("0.1", ECONF_SUCCESS, 0.1);
+  retval |= check_Double ("1e22", ECONF_SUCCESS, 1e22);
+  retval |= check_Double ("123456789012345678901234567890", ECONF_SUCCESS,
+			  123456789012345678901234567890.0);
+  retval |= check_Double ("2.2250738585072014e-308", ECONF_SUCCESS, 2.2250738585072014e-308);
+  retval |= check_Double ("1.7976931348623157e+308", ECONF_SUCCESS, 1.7976931348623157e+308);
+  retval |= check_Double (".5", ECONF_SUCCESS, 0.5);
+  retval |= check_Double ("5.", ECONF_SUCCESS, 5.0);
+  retval |= check_Double ("-Infinity", ECONF_SUCCESS, -HUGE_VAL);
+  retval |= check_Double ("1e400", ECONF_PARSE_ERROR, 0);
+  retval |= check_Double ("1.5e", ECONF_PARSE_ERROR, 0);
+  retval |= check_Double ("1.5.2", ECONF_PARSE_ERROR, 0);
+  retval |= check_Double ("0x1p3", ECONF_PARSE_ERROR, 0);
+  retval |= check_Double ("abc", ECONF_PARSE_ERROR, 0);
+
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_newKeyFile(&key_file, '=', '#')))
+    {
+      fprintf (stderr, "ERROR: couldn't create new file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+
+  retval |= check_all ();
+
+  /* The decimal point of these locales is ',', nothing may change */
+  if (setlocale (LC_ALL, "de_DE.UTF-8") || setlocale (LC_ALL, "fr_FR.UTF-8"))
+    retval |= check_all ();
+
+  econf_free (key_file);
+
+  return retval;
+}
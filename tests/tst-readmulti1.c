@@ -0,0 +1,140 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Read several projects sharing the same directories with
+   econf_readDirsMulti(), with one and with several threads, and check
+   that every result equals econf_readDirs() for the project, including
+   the error of a project without files and of an invalid one.
+*/
+
+#define USR_DIR TESTSDIR"tst-readmulti1-data/usr/etc"
+#define ETC_DIR TESTSDIR"tst-readmulti1-data/etc"
+
+static const econf_project projects[] = {
+  {"alpha", "conf"},
+  {"beta", ".conf"},
+  {"gamma", "ini"},
+  {"delta", "conf"},
+  {"", "conf"}
+};
+#define N (sizeof(projects) / sizeof(projects[0]))
+
+static int
+compare (econf_file *multi, econf_file *single, enum econf_iter_order order)
+{
+  econf_iter a, b;
+  econf_err ea, eb;
+  int retval = 0;
+
+  econf_iterInit(multi, order, &a);
+  econf_iterInit(single, order, &b);
+  while (!(ea = econf_iterNext(&a)) & !(eb = econf_iterNext(&b)))
+    {
+      if ((a.group == NULL) != (b.group == NULL) ||
+	  (a.group && strcmp(a.group, b.group) != 0) ||
+	  strcmp(a.key, b.key) != 0 || strcmp(a.value, b.value) != 0)
+	{
+	  fprintf (stderr, "ERROR: order %d: got %s %s=%s, expected %s %s=%s\n",
+		   order, a.group ? a.group : "NULL", a.key, a.value,
+		   b.group ? b.group : "NULL", b.key, b.value);
+	  retval = 1;
+	}
+    }
+  if (ea != ECONF_NOKEY || eb != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: order %d: different number of keys\n", order);
+      retval = 1;
+    }
+  return retval;
+}
+
+static int
+check_multi (unsigned int threads)
+{
+  econf_file *results[N], *single;
+  econf_err status[N], error, expected;
+  int retval = 0;
+
+  error = econf_readDirsMulti(results, status, projects, N, USR_DIR, ETC_DIR,
+			      "=", "#", threads, ECONF_REFRESHABLE);
+  if (error != ECONF_NOFILE)
+    {
+      fprintf (stderr, "ERROR: %u threads: econf_readDirsMulti returned %s\n",
+	       threads, econf_errString(error));
+      retval = 1;
+    }
+
+  for (size_t i = 0; i < N; i++)
+    {
+      single = NULL;
+      expected = econf_readDirs(&single, USR_DIR, ETC_DIR,
+				projects[i].project_name,
+				projects[i].config_suffix, "=", "#");
+      if (status[i] != expected || (results[i] == NULL) != (single == NULL))
+	{
+	  fprintf (stderr, "ERROR: %u threads: project '%s': %s, expected %s\n",
+		   threads, projects[i].project_name,
+		   econf_errString(status[i]), econf_errString(expected));
+	  retval = 1;
+	}
+      else if (single != NULL)
+	{
+	  retval |= compare (results[i], single, ECONF_ITER_FILE_ORDER);
+	  retval |= compare (results[i], single, ECONF_ITER_GROUPED);
+	  /* The results know their files like those of
+	     econf_readDirsWithFlags() */
+	  if ((error = econf_refresh (results[i])))
+	    {
+	      fprintf (stderr, "ERROR: refreshing '%s': %s\n",
+		       projects[i].project_name, econf_errString(error));
+	      retval = 1;
+	    }
+	}
+      econf_free (single);
+      econf_free (results[i]);
+    }
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_file *results[2];
+  econf_err error;
+  int retval = 0;
+
+  retval |= check_multi (1);
+  retval |= check_multi (4);
+
+  /* Success if all projects can be read, status is optional */
+  if ((error = econf_readDirsMulti(results, NULL, projects, 2, USR_DIR,
+				   ETC_DIR, "=", "#", 2, 0)))
+    {
+      fprintf (stderr, "ERROR: reading two projects: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  else
+    {
+      const char *val;
+      if (econf_getStringValueRef(results[0], "Main", "Level", &val) ||
+	  strcmp(val, "3") != 0 ||
+	  econf_getStringValueRef(results[1], "Main", "Name", &val) ||
+	  strcmp(val, "beta") != 0)
+	{
+	  fprintf (stderr, "ERROR: wrong values read\n");
+	  retval = 1;
+	}
+      econf_free (results[0]);
+      econf_free (results[1]);
+    }
+
+  return retval;
+}
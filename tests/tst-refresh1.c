@@ -0,0 +1,270 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Read a vendor file and drop-ins from a temporary directory with
+   econf_readDirsWithFlags() and ECONF_REFRESHABLE, change, add and
+   remove drop-ins and check that econf_refresh() gives the same result
+   as reading everything again, that it parses only the changed files
+   and that it leaves the file alone if nothing changed. Files read
+   without ECONF_REFRESHABLE can't be refreshed.
+*/
+
+static char dir[] = "/tmp/tst-refresh1-XXXXXX";
+
+static const char *paths[] = {
+  "usr", "usr/refresh.conf.d", "etc", "etc/refresh.conf.d"
+};
+
+static int
+write_file (const char *name, const char *contents)
+{
+  char path[256];
+  FILE *fp;
+
+  snprintf (path, sizeof(path), "%s/%s", dir, name);
+  if ((fp = fopen (path, "w")) == NULL)
+    {
+      fprintf (stderr, "ERROR: couldn't write %s\n", path);
+      return 1;
+    }
+  fputs (contents, fp);
+  fclose (fp);
+  return 0;
+}
+
+static void
+remove_file (const char *name)
+{
+  char path[256];
+
+  snprintf (path, sizeof(path), "%s/%s", dir, name);
+  unlink (path);
+}
+
+static void
+remove_files (void)
+{
+  char path[256];
+
+  remove_file ("usr/refresh.conf");
+  remove_file ("usr/refresh.conf.d/10-client.conf");
+  remove_file ("etc/refresh.conf.d/20-server.conf");
+  remove_file ("etc/refresh.conf.d/30-new.conf");
+  for (int i = sizeof(paths) / sizeof(paths[0]) - 1; i >= 0; i--)
+    {
+      snprintf (path, sizeof(path), "%s/%s", dir, paths[i]);
+      rmdir (path);
+    }
+  rmdir (dir);
+}
+
+static econf_err
+read_dirs (econf_file **key_file, unsigned int flags)
+{
+  char usr[256], etc[256];
+
+  snprintf (usr, sizeof(usr), "%s/usr", dir);
+  snprintf (etc, sizeof(etc), "%s/etc", dir);
+  return econf_readDirsWithFlags (key_file, usr, etc, "refresh", "conf", "=",
+				  "#", flags);
+}
+
+static int
+compare (econf_file *refreshed, econf_file *reread, enum econf_iter_order order)
+{
+  econf_iter a, b;
+  econf_err ea, eb;
+  int retval = 0;
+
+  econf_iterInit(refreshed, order, &a);
+  econf_iterInit(reread, order, &b);
+  while (!(ea = econf_iterNext(&a)) & !(eb = econf_iterNext(&b)))
+    {
+      if ((a.group == NULL) != (b.group == NULL) ||
+	  (a.group && strcmp(a.group, b.group) != 0) ||
+	  strcmp(a.key, b.key) != 0 || strcmp(a.value, b.value) != 0)
+	{
+	  fprintf (stderr, "ERROR: order %d: got %s %s=%s, expected %s %s=%s\n",
+		   order, a.group ? a.group : "NULL", a.key, a.value,
+		   b.group ? b.group : "NULL", b.key, b.value);
+	  retval = 1;
+	}
+    }
+  if (ea != ECONF_NOKEY || eb != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: order %d: different number of keys\n", order);
+      retval = 1;
+    }
+  return retval;
+}
+
+/* Refresh key_file and compare it with reading the files again */
+static int
+check_refresh (econf_file *key_file)
+{
+  econf_file *reread = NULL;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_refresh (key_file)) || (error = read_dirs (&reread, 0)))
+    {
+      fprintf (stderr, "ERROR: refreshing: %s\n", econf_errString(error));
+      return 1;
+    }
+  retval |= compare (key_file, reread, ECONF_ITER_FILE_ORDER);
+  retval |= compare (key_file, reread, ECONF_ITER_GROUPED);
+  econf_free (reread);
+  return retval;
+}
+
+static int
+run (void)
+{
+  econf_file *key_file = NULL, *other = NULL;
+  econf_keyhandle h;
+  const char *vendor, *val;
+  int32_t port;
+  econf_err error;
+  int retval = 0;
+
+  if (write_file ("usr/refresh.conf",
+		  "[Server]\nPort=80\nHost=vendor\n[Client]\nRetries=1\n") ||
+      write_file ("usr/refresh.conf.d/10-client.conf",
+		  "Name=dropin\n[Client]\nRetries=2\nTimeout=5\n") ||
+      write_file ("etc/refresh.conf.d/20-server.conf",
+		  "[Server]\nPort=81\n[Log]\nLevel=info\n"))
+    return 1;
+
+  if ((error = read_dirs (&other, 0)) ||
+      (error = econf_refresh (other)) != ECONF_ERROR)
+    {
+      fprintf (stderr, "ERROR: refreshing a file read without "
+	       "ECONF_REFRESHABLE returned: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  econf_free (other);
+  other = NULL;
+
+  if ((error = read_dirs (&key_file, ECONF_REFRESHABLE)))
+    {
+      fprintf (stderr, "ERROR: econf_readDirsWithFlags: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+  econf_getStringValueRef (key_file, "Server", "Host", &vendor);
+
+  /* Nothing changed, handles stay valid */
+  if ((error = econf_resolveKey (key_file, "Server", "Port", &h)) ||
+      (error = econf_refresh (key_file)) ||
+      (error = econf_getIntValueH (key_file, h, &port)) || port != 81)
+    {
+      fprintf (stderr, "ERROR: refresh without changes: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  /* Change one drop-in, add one and remove one */
+  if (write_file ("etc/refresh.conf.d/20-server.conf",
+		  "[Server]\nPort=8081\nHost=etc\n[Log]\nLevel=debug\n") ||
+      write_file ("etc/refresh.conf.d/30-new.conf",
+		  "[Cache]\nSize=1\n[Client]\nTimeout=7\n"))
+    retval = 1;
+  remove_file ("usr/refresh.conf.d/10-client.conf");
+  retval |= check_refresh (key_file);
+
+  if ((error = econf_getIntValueH (key_file, h, &port)) != ECONF_INVALID_HANDLE)
+    {
+      fprintf (stderr, "ERROR: outdated handle returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  if (econf_getIntValue (key_file, "Server", "Port", &port) || port != 8081)
+    {
+      fprintf (stderr, "ERROR: Port is %d, expected 8081\n", port);
+      retval = 1;
+    }
+
+  /* Host comes from the vendor file again, which was not parsed again
+     and still holds the same string */
+  remove_file ("etc/refresh.conf.d/20-server.conf");
+  retval |= check_refresh (key_file);
+  if (econf_getStringValueRef (key_file, "Server", "Host", &val) ||
+      val != vendor)
+    {
+      fprintf (stderr, "ERROR: the vendor file was parsed again\n");
+      retval = 1;
+    }
+
+  /* Changes made with the setters are dropped once a file changes */
+  econf_setIntValue (key_file, "Server", "Port", 1);
+  write_file ("usr/refresh.conf",
+	      "[Server]\nPort=90\nHost=vendor2\n[Client]\nRetries=1\n");
+  retval |= check_refresh (key_file);
+
+  /* Without any file left the old contents are kept */
+  remove_file ("usr/refresh.conf");
+  remove_file ("etc/refresh.conf.d/30-new.conf");
+  if ((error = econf_refresh (key_file)) != ECONF_NOFILE ||
+      econf_getIntValue (key_file, "Server", "Port", &port) || port != 90)
+    {
+      fprintf (stderr, "ERROR: refresh without files: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  if ((error = econf_newKeyFile (&other, '=', '#')) ||
+      (error = econf_refresh (other)) != ECONF_ERROR)
+    {
+      fprintf (stderr, "ERROR: refreshing a new file returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+  econf_freeze (key_file);
+  if ((error = econf_refresh (key_file)) != ECONF_FROZEN)
+    {
+      fprintf (stderr, "ERROR: refreshing a frozen file returned: %s\n",
+	       econf_errString(error));
+      retval = 1;
+    }
+
+  econf_free (other);
+  econf_free (key_file);
+  return retval;
+}
+
+int
+main(void)
+{
+  char path[256];
+  int retval;
+
+  if (mkdtemp (dir) == NULL)
+    {
+      fprintf (stderr, "ERROR: couldn't create %s\n", dir);
+      return 1;
+    }
+  for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+    {
+      snprintf (path, sizeof(path), "%s/%s", dir, paths[i]);
+      if (mkdir (path, 0755))
+	{
+	  fprintf (stderr, "ERROR: couldn't create %s\n", path);
+	  remove_files ();
+	  return 1;
+	}
+    }
+
+  retval = run ();
+  remove_files ();
+  return retval;
+}
@@ -152,6 +152,52 @@ main(void)
   if (!check_Bool (key_file, "No", false)) retval=1;
   if (!check_Bool (key_file, "no", false)) retval=1;
   if (!check_Bool (key_file, "0", false)) retval=1;
+  if (!check_Bool (key_file, "TRUE", true)) retval=1;
+  if (!check_Bool (key_file, "nO", false)) retval=1;
+  if (!check_Bool (key_file, "", false)) retval=1;
+
+  /* The setter stores the canonical form, other strings are rejected */
+  char *val;
+  if ((error = econf_setBoolValue(key_file, NULL, "KEY", "YeS")) ||
+      (error = econf_getStringValue(key_file, NULL, "KEY", &val)))
+    {
+      fprintf (stderr, "ERROR: Bool 'YeS': %s\n", econf_errString(error));
+      retval = 1;
+    }
+  else
+    {
+      if (strcmp (val, "true") != 0)
+	{
+	  fprintf (stderr, "ERROR: Bool 'YeS' stored as '%s'\n", val);
+	  retval = 1;
+	}
+      free (val);
+    }
+  if ((error = econf_setBoolValue(key_file, NULL, "KEY", "yess")) != ECONF_ERROR)
+    {
+      fprintf (stderr, "ERROR: Bool 'yess' accepted: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  /* The null value is stored as is */
+  if ((error = econf_setBoolValue(key_file, NULL, "KEY", "_none_")))
+    {
+      fprintf (stderr, "ERROR: Bool '_none_': %s\n", econf_errString(error));
+      retval = 1;
+    }
+  econf_setStringValue(key_file, NULL, "KEY", "10");
+  bool b;
+  if ((error = econf_getBoolValue(key_file, NULL, "KEY", &b)) != ECONF_PARSE_ERROR)
+    {
+      fprintf (stderr, "ERROR: Bool '10' parsed: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  /* Only ASCII letters are folded, control bytes are not digits */
+  econf_setStringValue(key_file, NULL, "KEY", "\x11");
+  if ((error = econf_getBoolValue(key_file, NULL, "KEY", &b)) != ECONF_PARSE_ERROR)
+    {
+      fprintf (stderr, "ERROR: Bool '\\x11' parsed: %s\n", econf_errString(error));
+      retval = 1;
+    }
 
   econf_free (key_file);
 
@@ -0,0 +1,121 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Check that econf_getValueSource() returns the file and line each value
+   of a merged file was read from, also after freezing it, and that values
+   set by the program have no source.
+*/
+
+static int
+check_source (econf_file *key_file, const char *group, const char *key,
+	      const char *file, uint64_t line)
+{
+  const char *path;
+  uint64_t line_number;
+  econf_err error;
+
+  if ((error = econf_getValueSource(key_file, group, key, &path, &line_number)))
+    {
+      fprintf (stderr, "ERROR: %s/%s: %s\n", group ? group : "NULL", key,
+	       econf_errString(error));
+      return 1;
+    }
+  if (file == NULL ? path != NULL :
+      (path == NULL || strlen(path) < strlen(file) ||
+       strcmp(path + strlen(path) - strlen(file), file) != 0))
+    {
+      fprintf (stderr, "ERROR: %s/%s: source is %s, expected %s\n",
+	       group ? group : "NULL", key, path ? path : "NULL",
+	       file ? file : "NULL");
+      return 1;
+    }
+  if (line_number != line)
+    {
+      fprintf (stderr, "ERROR: %s/%s: line is %lu, expected %lu\n",
+	       group ? group : "NULL", key, line_number, line);
+      return 1;
+    }
+  return 0;
+}
+
+static int
+check_merged (econf_file *key_file)
+{
+  int retval = 0;
+
+  retval |= check_source (key_file, NULL, "Name", "/20-server.conf", 1);
+  retval |= check_source (key_file, "Server", "Port", "/20-server.conf", 4);
+  retval |= check_source (key_file, "Server", "Host", "/30-new.conf", 6);
+  retval |= check_source (key_file, "Server", "Log", "/20-server.conf", 5);
+  retval |= check_source (key_file, "Client", "Retries", "/10-client.conf", 4);
+  retval |= check_source (key_file, "Client", "Timeout", "/30-new.conf", 2);
+  retval |= check_source (key_file, "Log", "File", "/20-server.conf", 9);
+  retval |= check_source (key_file, "Cache", "Ttl", "/30-new.conf", 10);
+  return retval;
+}
+
+int
+main(void)
+{
+  econf_file *key_file = NULL, *merged = NULL;
+  const char *path;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_readFile (&key_file, TESTSDIR"tst-merge6-data/usr/etc/merge.conf", "=", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n",
+	       econf_errString(error));
+      return 1;
+    }
+  retval |= check_source (key_file, "Server", "Host", "/usr/etc/merge.conf", 3);
+  retval |= check_source (key_file, "Client", "Retries", "/usr/etc/merge.conf", 6);
+
+  /* Changed and new values come from the program */
+  econf_setStringValue (key_file, "Server", "Host", "changed");
+  econf_setStringValue (key_file, "Server", "New", "new");
+  retval |= check_source (key_file, "Server", "Host", NULL, 0);
+  retval |= check_source (key_file, "Server", "New", NULL, 0);
+  econf_iter iter;
+  econf_iterInit (key_file, ECONF_ITER_FILE_ORDER, &iter);
+  while (!econf_iterNext (&iter))
+    {
+      uint64_t line = strcmp (iter.key, "Host") == 0 ? 0 :
+		      strcmp (iter.key, "Retries") == 0 ? 6 : iter.line_number;
+      if (iter.line_number != line)
+	{
+	  fprintf (stderr, "ERROR: iterator: %s is on line %llu, expected %llu\n",
+		   iter.key, (unsigned long long) iter.line_number,
+		   (unsigned long long) line);
+	  retval = 1;
+	}
+    }
+  if ((error = econf_getValueSource (key_file, "Server", "Missing", &path, NULL)) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "ERROR: missing key returned: %s\n", econf_errString(error));
+      retval = 1;
+    }
+  econf_free (key_file);
+
+  if ((error = econf_readDirs(&merged, TESTSDIR"tst-merge6-data/usr/etc",
+			      TESTSDIR"tst-merge6-data/etc", "merge", "conf",
+			      "=", "#")))
+    {
+      fprintf (stderr, "ERROR: econf_readDirs: %s\n", econf_errString(error));
+      return 1;
+    }
+  retval |= check_merged (merged);
+  econf_freeze (merged);
+  retval |= check_merged (merged);
+  econf_free (merged);
+
+  return retval;
+}
@@ -0,0 +1,91 @@
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libeconf.h"
+
+/* Test case:
+   Read a file and check that the borrowed strings returned by
+   econf_getStringValueRef(), econf_getStringValueRefLen() and
+   econf_iterNext() match the copies returned by econf_getKeys() and
+   econf_getStringValue().
+*/
+
+int
+main(void)
+{
+  econf_file *key_file = NULL;
+  char **keys;
+  size_t key_number;
+  econf_err error;
+  int retval = 0;
+
+  if ((error = econf_readFile (&key_file, TESTSDIR"tst-logindefs2-data/logindefs.data", "= \t", "#")))
+    {
+      fprintf (stderr, "ERROR: couldn't read configuration file: %s\n", econf_errString(error));
+      return 1;
+    }
+
+  if ((error = econf_getKeys(key_file, NULL, &key_number, &keys)))
+    {
+      fprintf (stderr, "Error getting all keys: %s\n", econf_errString(error));
+      econf_free(key_file);
+      return 1;
+    }
+
+  econf_iter iter;
+  size_t pos = 0;
+  econf_iterInit(key_file, ECONF_ITER_GROUPED, &iter);
+  while (!(error = econf_iterNext(&iter)))
+    {
+      const char *key = iter.key, *value = iter.value;
+      char *copy = NULL;
+      const char *ref;
+      size_t length;
+
+      pos++;
+      if (pos > key_number || strcmp(keys[pos - 1], key) != 0)
+	{
+	  fprintf (stderr, "Key %lu: got '%s', expected '%s'\n", pos - 1, key,
+		   pos > key_number ? "NULL" : keys[pos - 1]);
+	  retval = 1;
+	  break;
+	}
+      econf_getStringValue(key_file, NULL, key, &copy);
+      if ((error = econf_getStringValueRefLen(key_file, NULL, key, &ref, &length)))
+	{
+	  fprintf (stderr, "Error getting '%s': %s\n", key, econf_errString(error));
+	  retval = 1;
+	}
+      else if (ref != value || (copy == NULL) != (ref == NULL) ||
+	       (ref && (strcmp(copy, ref) != 0 || strlen(ref) != length)) ||
+	       (!ref && length != 0))
+	{
+	  fprintf (stderr, "Wrong value for '%s': '%s' (%lu), expected '%s'\n",
+		   key, ref ? ref : "NULL", length, copy ? copy : "NULL");
+	  retval = 1;
+	}
+      free (copy);
+    }
+  if (error != ECONF_NOKEY || pos != key_number)
+    {
+      fprintf (stderr, "Iteration stopped after %lu of %lu keys: %s\n",
+	       pos, key_number, econf_errString(error));
+      retval = 1;
+    }
+
+  const char *ref = NULL;
+  if ((error = econf_getStringValueRef(key_file, NULL, "DOESNOTEXIST", &ref)) != ECONF_NOKEY)
+    {
+      fprintf (stderr, "Missing key returned: %s\n", econf_errString(error));
+      retval = 1;
+    }
+
+  econf_free (keys);
+  econf_free (key_file);
+
+  return retval;
+}
@@ -198,48 +198,35 @@ int main (int argc, char *argv[])
             return EXIT_FAILURE;
         }
 
-        char **groups = NULL;
-        char *value = NULL;
-        size_t group_count = 0;
-
-        /* show groups, keys and their value */
-        if ((error = econf_getGroups(key_file, &group_count, &groups))) {
-            fprintf(stderr, "%s\n", econf_errString(error));
-            econf_free(groups);
-            econf_free(key_file);
-            return EXIT_FAILURE;
-        }
-        char **keys = NULL;
-        size_t key_count = 0;
+        econf_iter iter;
+        const char *group = NULL;
 
-        for (size_t g = 0; g < group_count; g++)
-        {
-            if (error = econf_getKeys(key_file, groups[g], &key_count, &keys))
-            {
-                fprintf(stderr, "%s\n", econf_errString(error));
-                econf_free(groups);
-                econf_free(keys);
+        /* show groups, keys and their value in a single pass; everything
+         * is borrowed from key_file, nothing to free
+         */
+        econf_iterInit(key_file, ECONF_ITER_GROUPED, &iter);
+        while (!(error = econf_iterNext(&iter))) {
+            if (iter.group == NULL)
+                continue;
+            if (iter.value == NULL || strlen(iter.value) == 0) {
+                fprintf(stderr, "%s\n", econf_errString(ECONF_EMPTYKEY));
                 econf_free(key_file);
                 return EXIT_FAILURE;
             }
-            printf("%s\n", groups[g]);
-            for (size_t k = 0; k < key_count; k++) {
-                if ((error = econf_getStringValue(key_file, groups[g], keys[k], &value))
-                    || value == NULL || strlen(value) == 0) {
-                    fprintf(stderr, "%s\n", econf_errString(error));
-                    econf_free(groups);
-                    econf_free(keys);
-                    econf_free(key_file);
-                    free(value);
-                    return EXIT_FAILURE;
-                }
-                printf("%s = %s\n", keys[k], value);
-                free(value);
+            if (group == NULL || strcmp(group, iter.group) != 0) {
+                if (group != NULL)
+                    printf("\n");
+                printf("%s\n", iter.group);
+                group = iter.group;
             }
-            printf("\n");
-            econf_free(keys);
+            printf("%s = %s\n", iter.key, iter.value);
         }
-        econf_free(groups);
+        if (error != ECONF_NOKEY || group == NULL) {
+            fprintf(stderr, "%s\n", econf_errString(group ? error : ECONF_ERROR));
+            econf_free(key_file);
+            return EXIT_FAILURE;
+        }
+        printf("\n");
 
     /****************************************************************
      * @brief This command will print the content of the files and the name of the